@@ -5,6 +5,13 @@ struct inode;
 struct pipe;
 struct proc;
 struct rtcdate;
+struct schedstat;
+struct lockstat;
+struct timerstat;
+struct schedtrace;
+struct schedconf;
+struct leasestat;
+struct edfstat;
 struct spinlock;
 struct sleeplock;
 struct stat;
@@ -76,7 +83,11 @@ void            kbdintr(void);
 void            cmostime(struct rtcdate *r);
 int             lapicid(void);
 extern volatile uint*    lapic;
+extern uint     tsc_per_tick;
 void            lapiceoi(void);
+void            lapicipi(int);
+void            lapiconeshot(uint);
+void            lapicperiodic(void);
 void            lapicinit(void);
 void            lapicstartap(uchar, uint);
 void            microdelay(int);
@@ -122,8 +133,17 @@ void            wakeup(void*);
 void            yield(void);
 int             getLevel(void);
 void            setPriority(int, int);
+int             setTickets(int, int);
+int             setDeadline(int, int);
+void            getEDFStat(struct edfstat*);
 void            schedulerLock(int);
 void            schedulerUnlock(int);
+void            getSchedStat(struct schedstat*);
+void            getLockStat(struct lockstat*);
+void            getSchedConf(struct schedconf*);
+int             setSchedConf(struct schedconf*);
+void            getLeaseStat(struct leasestat*);
+void            schedinherit(int);
 
 // swtch.S
 void            swtch(struct context**, struct context*);
@@ -161,7 +181,17 @@ int             fetchstr(uint, char**);
 void            syscall(void);
 
 // timer.c
-void            timerinit(void);
+void            timertick(void);
+uint            timerticks(void);
+int             timersleep(int);
+uint            timernext(void);
+void            getTimerStat(struct timerstat*);
+
+// trace.c
+void            traceinit(void);
+void            tracesched(struct schedtrace*);
+void            traceevent(struct proc*, int);
+int             getSchedTrace(struct schedtrace*, int);
 
 // trap.c
 void            idtinit(void);
@@ -0,0 +1,147 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "timerstat.h"
+#include "edfstat.h"
+
+// EDF deadline benchmark.
+// usage: edf_bench [jobs]
+// Periodic tasks do about half a tick of work every PERIOD ticks
+// while CPU-bound processes keep every cpu busy. A job misses when
+// its work is not done by the end of its period. The tasks run
+// once in the MLFQ and once admitted to the EDF class with
+// RUNTIME ticks per period, and the misses of both runs are printed.
+
+#define NUM_BG 8
+#define NUM_RT 3
+#define PERIOD 10
+#define RUNTIME 2
+#define WORK_US 5000
+
+struct result {
+  int admitted;
+  int jobs;
+  int misses;
+};
+
+uint work_loop;
+
+static inline unsigned long long
+rdtsc(void)
+{
+  unsigned long long t;
+  asm volatile("rdtsc" : "=A" (t));
+  return t;
+}
+
+// Loop iterations taking about WORK_US.
+void
+calibrate(uint cycles_per_us)
+{
+  unsigned long long start;
+  volatile int x;
+  uint us;
+
+  start = rdtsc();
+  for(x = 0; x < 1000000; x++)
+    ;
+  us = (uint)(rdtsc() - start) / cycles_per_us;
+  if(us == 0)
+    us = 1;
+  work_loop = 1000000 / us * WORK_US;
+}
+
+void
+periodic(int fd, int edf, int njobs)
+{
+  struct result r;
+  volatile int x;
+  int next;
+
+  r.admitted = edf && setDeadline(PERIOD, RUNTIME) == 0;
+  r.jobs = 0;
+  r.misses = 0;
+  // Start on a tick boundary.
+  sleep(1);
+  next = uptime();
+  while(r.jobs < njobs){
+    next += PERIOD;
+    for(x = 0; x < work_loop; x++)
+      ;
+    r.jobs++;
+    if(uptime() > next){
+      r.misses++;
+      next = uptime();
+    } else
+      sleep(next - uptime());
+  }
+  write(fd, &r, sizeof(r));
+  exit();
+}
+
+void
+run(int edf, int njobs)
+{
+  struct edfstat before, after;
+  struct result r;
+  int bg[NUM_BG];
+  int fds[2], i, admitted = 0, jobs = 0, misses = 0;
+  volatile int x;
+
+  if(pipe(fds) < 0){
+    printf(1, "pipe failed\n");
+    exit();
+  }
+  for(i = 0; i < NUM_BG; i++){
+    if((bg[i] = fork()) == 0){
+      for(;;)
+        x++;
+    }
+  }
+  getEDFStat(&before);
+  for(i = 0; i < NUM_RT; i++){
+    if(fork() == 0){
+      close(fds[0]);
+      periodic(fds[1], edf, njobs);
+    }
+  }
+  close(fds[1]);
+  while(read(fds[0], &r, sizeof(r)) == sizeof(r)){
+    admitted += r.admitted;
+    jobs += r.jobs;
+    misses += r.misses;
+  }
+  close(fds[0]);
+  getEDFStat(&after);
+  for(i = 0; i < NUM_BG; i++)
+    kill(bg[i]);
+  while(wait() != -1)
+    ;
+
+  printf(1, "%s: %d jobs, %d missed", edf ? "edf" : "mlfq", jobs, misses);
+  if(edf)
+    printf(1, " (%d of %d admitted; kernel: %d jobs, %d missed, %d rejected)",
+           admitted, NUM_RT, after.jobs - before.jobs,
+           after.misses - before.misses, after.rejected - before.rejected);
+  printf(1, "\n");
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct timerstat st;
+  int njobs;
+
+  njobs = 100;
+  if(argc > 1)
+    njobs = atoi(argv[1]);
+
+  getTimerStat(&st);
+  calibrate(st.tsc_per_tick / 10000);
+
+  printf(1, "EDF bench: %d tasks, %d of %d ticks, %d background\n",
+         NUM_RT, RUNTIME, PERIOD, NUM_BG);
+  run(0, njobs);
+  run(1, njobs);
+  exit();
+}
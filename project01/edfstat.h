@@ -0,0 +1,11 @@
+// EDF statistics, reported by getEDFStat(). admitted, rejected,
+// jobs and misses are counts since boot summed over the cpus; they
+// wrap, so subtract two snapshots for an interval. maxutil is the
+// EDF utilization of the most loaded cpu right now.
+struct edfstat {
+  uint admitted;   // setDeadline() calls admitted
+  uint rejected;   // setDeadline() calls over the utilization bound
+  uint jobs;       // Periods started
+  uint misses;     // Periods that ended with runtime the process wanted left
+  uint maxutil;    // Highest current EDF utilization of a cpu, per mille
+};
@@ -0,0 +1,64 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "lockstat.h"
+
+// fork/exit/wait stress test.
+// NUM_WORKER processes each fork and reap NUM_FORK children
+// while the contention on the process table locks is measured.
+
+#define NUM_WORKER 4
+#define NUM_FORK 500
+
+void
+worker(void)
+{
+  int i, pid;
+
+  for(i = 0; i < NUM_FORK; i++){
+    pid = fork();
+    if(pid < 0){
+      printf(1, "fork failed\n");
+      exit();
+    }
+    if(pid == 0)
+      exit();
+    wait();
+  }
+  exit();
+}
+
+void
+report(char *name, struct lockcount *before, struct lockcount *after)
+{
+  int acquire = after->acquire - before->acquire;
+  int spin = after->spin - before->spin;
+
+  printf(1, "%s: %d acquires, %d spins, %d acquires/fork\n",
+         name, acquire, spin, acquire / (NUM_WORKER * NUM_FORK));
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct lockstat before, after;
+  int i, start;
+
+  printf(1, "fork stress start\n");
+  getLockStat(&before);
+  start = uptime();
+
+  for(i = 0; i < NUM_WORKER; i++)
+    if(fork() == 0)
+      worker();
+  while(wait() != -1);
+
+  printf(1, "%d forks in %d ticks\n", NUM_WORKER * NUM_FORK, uptime() - start);
+  getLockStat(&after);
+  report("ptable", &before.ptable, &after.ptable);
+  report("proc", &before.proc, &after.proc);
+  report("mlfq", &before.mlfq, &after.mlfq);
+  report("sleepq", &before.sleepq, &after.sleepq);
+  printf(1, "done\n");
+  exit();
+}
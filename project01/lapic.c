@@ -32,6 +32,7 @@
 #define TIMER   (0x0320/4)   // Local Vector Table 0 (TIMER)
   #define X1         0x0000000B   // divide counts by 1
   #define PERIODIC   0x00020000   // Periodic
+  #define ONESHOT    0x00000000   // One-shot
 #define PCINT   (0x0340/4)   // Performance Counter LVT
 #define LINT0   (0x0350/4)   // Local Vector Table 1 (LINT0)
 #define LINT1   (0x0360/4)   // Local Vector Table 2 (LINT1)
@@ -43,6 +44,14 @@
 
 volatile uint *lapic;  // Initialized in mp.c
 
+// Timer counts per tick.
+#define TICKCOUNT 10000000
+
+// TSC cycles per tick, measured against the timer at boot.
+uint tsc_per_tick;
+
+static void lapiccalibrate(void);
+
 //PAGEBREAK!
 static void
 lapicw(int index, int value)
@@ -65,8 +74,9 @@ lapicinit(void)
   // If xv6 cared more about precise timekeeping,
   // TICR would be calibrated using an external time source.
   lapicw(TDCR, X1);
-  lapicw(TIMER, PERIODIC | (T_IRQ0 + IRQ_TIMER));
-  lapicw(TICR, 10000000);
+  if(tsc_per_tick == 0)
+    lapiccalibrate();
+  lapicperiodic();
 
   // Disable logical interrupt lines.
   lapicw(LINT0, MASKED);
@@ -97,6 +107,68 @@ lapicinit(void)
   lapicw(TPR, 0);
 }
 
+// Measure the TSC against a tenth of a tick of the timer,
+// so that ticks can be kept by the TSC when a cpu stops its timer.
+// Done once, by the boot cpu.
+static void
+lapiccalibrate(void)
+{
+  unsigned long long start;
+
+  lapicw(TIMER, MASKED | ONESHOT | (T_IRQ0 + IRQ_TIMER));
+  start = rdtsc();
+  lapicw(TICR, TICKCOUNT / 10);
+  while(lapic[TCCR] != 0)
+    ;
+  tsc_per_tick = (rdtsc() - start) * 10;
+}
+
+// Interrupt every tick.
+void
+lapicperiodic(void)
+{
+  if(!lapic)
+    return;
+  lapicw(TIMER, PERIODIC | (T_IRQ0 + IRQ_TIMER));
+  lapicw(TICR, TICKCOUNT);
+}
+
+// Interrupt once, cycles TSC cycles from now,
+// or never if cycles is 0. Used by idle cpus.
+void
+lapiconeshot(uint cycles)
+{
+  uint n, unit;
+
+  if(!lapic)
+    return;
+  lapicw(TIMER, ONESHOT | (T_IRQ0 + IRQ_TIMER));
+  if(cycles == 0){
+    lapicw(TICR, 0);
+    return;
+  }
+  // Convert in thousandths of a tick to stay within 32 bits.
+  unit = tsc_per_tick / 1000;
+  n = cycles / unit + 1;
+  if(n > 0xFFFFFFFF / (TICKCOUNT / 1000))
+    n = 0xFFFFFFFF / (TICKCOUNT / 1000);
+  lapicw(TICR, n * (TICKCOUNT / 1000));
+}
+
+// Send the wakeup interrupt to the cpu with the given APIC ID.
+void
+lapicipi(int apicid)
+{
+  if(!lapic)
+    return;
+  pushcli();
+  lapicw(ICRHI, apicid<<24);
+  lapicw(ICRLO, FIXED | ASSERT | (T_IRQ0 + IRQ_WAKEUP));
+  while(lapic[ICRLO] & DELIVS)
+    ;
+  popcli();
+}
+
 int
 lapicid(void)
 {
@@ -0,0 +1,12 @@
+// schedulerLock lease statistics, reported by getLeaseStat().
+// All fields but maxdelayed are counts since boot summed over the
+// cpus, which wrap; subtract two snapshots for an interval.
+// maxdelayed is the largest of any cpu since boot and never drops.
+struct leasestat {
+  uint leases;       // Leases granted by schedulerLock()
+  uint expired;      // Leases ended by the time bound
+  uint held;         // Ticks leases were held
+  uint delayed;      // Process-ticks others waited behind a running holder
+  uint maxdelayed;   // Largest delayed of a single lease
+  uint inherits;     // Dependents of a blocked holder moved to the front
+};
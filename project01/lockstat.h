@@ -0,0 +1,15 @@
+// Acquisitions and failed spins of the process table locks,
+// summed per kind of lock, reported by getLockStat().
+// Both counts only grow from boot and wrap at 2^32, so compare
+// two snapshots taken around the interval of interest.
+struct lockcount {
+  uint acquire;     // Number of acquire() calls
+  uint spin;        // Failed xchg while the lock was held elsewhere
+};
+
+struct lockstat {
+  struct lockcount ptable;   // ptable.lock (parent links, wait/exit)
+  struct lockcount proc;     // every p->lock
+  struct lockcount mlfq;     // every per-cpu run queue lock
+  struct lockcount sleepq;   // every wait-channel bucket lock
+};
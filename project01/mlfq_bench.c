@@ -0,0 +1,71 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "schedstat.h"
+
+// Scheduling decision cost with a growing number of processes.
+// Half of the children spin and half sleep, so the cost
+// should stay flat no matter how many of them exist.
+
+#define NUM_TICKS 200
+
+#define NUM_RUNS 5
+
+// NPROC is 64; leave room for init, sh and this program.
+int nprocs[NUM_RUNS] = {4, 8, 16, 32, 60};
+
+void
+spin(void)
+{
+  volatile int x = 0;
+  for(;;)
+    x++;
+}
+
+void
+run(int n)
+{
+  struct schedstat before, after;
+  int pids[64];
+  int i, decisions;
+
+  for(i = 0; i < n; i++){
+    if((pids[i] = fork()) == 0){
+      if(i % 2)
+        sleep(100000);
+      spin();
+    }
+    if(pids[i] < 0){
+      printf(1, "fork failed\n");
+      n = i;
+      break;
+    }
+  }
+
+  getSchedStat(&before);
+  sleep(NUM_TICKS);
+  getSchedStat(&after);
+
+  for(i = 0; i < n; i++)
+    kill(pids[i]);
+  while(wait() != -1);
+
+  decisions = after.decisions - before.decisions;
+  if(decisions == 0)
+    decisions = 1;
+  printf(1, "%d procs: %d decisions, %d cycles/decision (max since boot %d), %d steals\n",
+         n, decisions, (after.cycles - before.cycles) / decisions,
+         after.max_cycles, after.steals - before.steals);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int i;
+
+  printf(1, "MLFQ bench start\n");
+  for(i = 0; i < NUM_RUNS; i++)
+    run(nprocs[i]);
+  printf(1, "done\n");
+  exit();
+}
@@ -0,0 +1,138 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "param.h"
+#include "timerstat.h"
+#include "schedconf.h"
+
+// MLFQ parameter benchmark, in the spirit of mlfq_test.
+// For each configuration a mix of CPU-bound and interactive
+// (sleep, then a short burst) processes is run, and the average
+// turnaround time (fork to exit) and response time (fork to first
+// run) of each kind is printed.
+// The parameters in use before the run are restored at the end.
+
+#define NUM_CPU_BOUND 4
+#define NUM_INTERACTIVE 4
+#define NUM_LOOP 20000000
+#define NUM_ROUND 30
+#define ROUND_LOOP 100000
+
+#define NUM_CONF 5
+
+char *names[NUM_CONF] = {
+  "default", "short quanta", "long quanta", "5 levels", "L2 round robin"
+};
+
+struct schedconf confs[NUM_CONF] = {
+  {3, {4, 6, 8}, 100, L2_POLICY_PRIORITY, 100},
+  {3, {1, 2, 4}, 100, L2_POLICY_PRIORITY, 100},
+  {3, {8, 16, 32}, 200, L2_POLICY_PRIORITY, 100},
+  {5, {2, 4, 6, 8, 10}, 100, L2_POLICY_PRIORITY, 100},
+  {3, {4, 6, 8}, 100, L2_POLICY_RR, 100},
+};
+
+struct result {
+  int interactive;
+  uint turnaround;   // ticks
+  uint response;     // us
+};
+
+uint cycles_per_us;
+
+static inline unsigned long long
+rdtsc(void)
+{
+  unsigned long long t;
+  asm volatile("rdtsc" : "=A" (t));
+  return t;
+}
+
+void
+child(int fd, int interactive, uint start, unsigned long long start_tsc)
+{
+  struct result r;
+  volatile int x = 0;
+  int i, j;
+
+  r.response = (uint)(rdtsc() - start_tsc) / cycles_per_us;
+  if(interactive){
+    for(i = 0; i < NUM_ROUND; i++){
+      sleep(1);
+      for(j = 0; j < ROUND_LOOP; j++)
+        x++;
+    }
+  } else {
+    for(i = 0; i < NUM_LOOP; i++)
+      x++;
+  }
+  r.turnaround = uptime() - start;
+  r.interactive = interactive;
+  write(fd, &r, sizeof(r));
+  exit();
+}
+
+void
+run(int n)
+{
+  struct result r;
+  uint turnaround[2] = {0, 0}, response[2] = {0, 0}, count[2] = {0, 0};
+  unsigned long long start_tsc;
+  int fds[2], i, k;
+  uint start;
+
+  if(setSchedConf(&confs[n]) < 0){
+    printf(1, "%s: invalid parameters\n", names[n]);
+    return;
+  }
+  if(pipe(fds) < 0){
+    printf(1, "pipe failed\n");
+    exit();
+  }
+  for(i = 0; i < NUM_CPU_BOUND + NUM_INTERACTIVE; i++){
+    k = i >= NUM_CPU_BOUND;
+    start = uptime();
+    start_tsc = rdtsc();
+    if(fork() == 0){
+      close(fds[0]);
+      child(fds[1], k, start, start_tsc);
+    }
+  }
+  close(fds[1]);
+  while(read(fds[0], &r, sizeof(r)) == sizeof(r)){
+    turnaround[r.interactive] += r.turnaround;
+    response[r.interactive] += r.response;
+    count[r.interactive]++;
+  }
+  close(fds[0]);
+  while(wait() != -1)
+    ;
+
+  printf(1, "%s:\n", names[n]);
+  for(k = 0; k < 2; k++){
+    if(count[k] == 0)
+      continue;
+    printf(1, "  %s: turnaround %d ms, response %d us\n",
+           k ? "interactive" : "cpu-bound",
+           turnaround[k] * 10 / count[k], response[k] / count[k]);
+  }
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct timerstat st;
+  struct schedconf saved;
+  int i;
+
+  getTimerStat(&st);
+  cycles_per_us = st.tsc_per_tick / 10000;
+  getSchedConf(&saved);
+
+  printf(1, "MLFQ mix start\n");
+  for(i = 0; i < NUM_CONF; i++)
+    run(i);
+  setSchedConf(&saved);
+  printf(1, "done\n");
+  exit();
+}
@@ -1,11 +1,26 @@
 #include "types.h"
 #include "stat.h"
 #include "user.h"
+#include "param.h"
+#include "schedconf.h"
+#include "leasestat.h"
+
+// Busy loop for n ticks.
+void
+spin(int n)
+{
+    int start = uptime();
+
+    while(uptime() - start < n)
+        ;
+}
 
 int
 main(int argc, char *argv[])
 {
     int pid = 0;
+    struct schedconf conf;
+    struct leasestat before, after;
 
     char cmd = argv[1][0];
     switch (cmd) {
@@ -55,6 +70,36 @@ main(int argc, char *argv[])
         }
         printf(1, "[Test 2] finished\n");
         break;
+    case '3':
+        printf(1, "[Test 3] scheduler Lock lease and inheritance\n");
+        getSchedConf(&conf);
+        getLeaseStat(&before);
+        for(int i = 0; i < 3; i++) {
+            if(fork() == 0) {
+                spin(conf.lease + 100);
+                exit();
+            }
+        }
+        schedulerLock(2019044711);
+        // The child we wait for inherits our lease priority.
+        pid = fork();
+        if(pid == 0) {
+            spin(10);
+            exit();
+        }
+        wait();
+        // Hold on past the lease; it ends without schedulerUnlock.
+        spin(conf.lease + 10);
+        while(wait() != -1);
+        getLeaseStat(&after);
+        printf(1, "leases %d, expired %d, held %d ticks\n",
+               after.leases - before.leases, after.expired - before.expired,
+               after.held - before.held);
+        printf(1, "others delayed %d process-ticks (max %d per lease), %d inherits\n",
+               after.delayed - before.delayed, after.maxdelayed,
+               after.inherits - before.inherits);
+        printf(1, "[Test 3] finished\n");
+        break;
     default:
         printf(1, "WRONG CMD\n");
         break;
@@ -12,3 +12,4 @@
 #define NBUF         (MAXOPBLOCKS*3)  // size of disk block cache
 #define FSSIZE       1000  // size of file system in blocks
 
+#define MLFQ_MAXLEVEL 8  // maximum number of MLFQ levels (see setSchedConf)
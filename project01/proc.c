@@ -4,94 +4,168 @@
 #include "memlayout.h"
 #include "mmu.h"
 #include "x86.h"
-#include "proc.h"
 #include "spinlock.h"
+#include "proc.h"
+#include "schedstat.h"
+#include "lockstat.h"
+#include "schedtrace.h"
+#include "schedconf.h"
+#include "leasestat.h"
+#include "edfstat.h"
 
 #define PASSWORD 2019044711
 
+// ptable.lock protects p->parent and keeps wait() from
+// missing the wakeup of an exiting child. Process state is
+// protected by each p->lock (see proc.h).
 struct {
   struct spinlock lock;
   struct proc proc[NPROC];
 } ptable;
 
-// MLFQ LEVEL
-#define MLFQ_LEVEL 3
-
-// Queue type for process
-struct proc_queue_t {
-  struct proc* data[NPROC];
-  
-  // for traversal
-  int front;
-  int rear;
-  int size;
+// Wait channels
+// Sleeping processes are chained in a bucket chosen by hashing
+// their chan, so wakeup() only visits processes that may be
+// sleeping on it. Lock order: bucket lock, then p->lock,
+// then the run queue lock.
+#define NSLEEPQ_SHIFT 6
+#define NSLEEPQ (1 << NSLEEPQ_SHIFT)
 
-  // for schedulerLock, Unlock
-  int is_locked;
+struct sleepq {
+  struct spinlock lock;
+  struct proc *head;
 };
 
-// MLFQ structure
-// 3-Level feedback queue
-struct {
-  struct proc_queue_t queue[MLFQ_LEVEL];
-  // is_locked for schedulerLock, Unlock
-  int is_locked;
-  // global_ticks is tick for MLFQ scheduler
-  uint global_ticks;
-} MLFQ;
+struct sleepq sleepq[NSLEEPQ];
+
+// Bucket of the given wait channel
+static struct sleepq*
+sleepq_of(void *chan)
+{
+  return &sleepq[((uint)chan * 2654435761U) >> (32 - NSLEEPQ_SHIFT)];
+}
+
+// The MLFQ types live in proc.h since every struct cpu owns one.
+// A process belongs to the MLFQ of cpus[p->cpu]; each one is
+// protected by its own lock.
+
+// MLFQ of the given process
+// MLFQ parameters, shared by all cpus.
+// Written with every MLFQ lock held (see setSchedConf),
+// so holding any one MLFQ lock is enough to read them.
+static struct schedconf conf;
+
+static struct mlfq*
+mlfq_of(struct proc *p)
+{
+  return &cpus[p->cpu].mlfq;
+}
+
+// Lock the MLFQ of p and return it.
+// p->cpu changes when another cpu steals p, under the lock of the
+// MLFQ it leaves, so it is checked again once that lock is held.
+static struct mlfq*
+mlfq_lock(struct proc *p)
+{
+  struct mlfq *m;
+
+  for(;;){
+    m = mlfq_of(p);
+    acquire(&m->lock);
+    if(m == mlfq_of(p))
+      return m;
+    release(&m->lock);
+  }
+}
 
 // MLFQ initialization
 void 
-mlfq_initalization(void) {
+mlfq_initalization(struct mlfq *m) {
   
   // For traversal
   struct proc_queue_t *temp;
   
   // Initialize queue 
-  for (int l = 0; l < MLFQ_LEVEL; ++l){
-    temp = &MLFQ.queue[l];
+  for (int q = 0; q < MLFQ_NQUEUE; ++q){
+    temp = &m->queue[q];
     
     memset(temp->data, 0, sizeof(struct proc *) * NPROC);
     
     temp->front = 1;
     temp->rear = 0;
     temp->size = 0;
-    temp->is_locked = 0;
   }
+  m->bitmap = 0;
+  m->nready = 0;
+  m->stride.size = 0;
+  m->edf.size = 0;
+  m->nthrottled = 0;
+  m->edf_util = 0;
+  m->admitted = 0;
+  m->rejected = 0;
+  m->jobs = 0;
+  m->misses = 0;
+  m->vtime = 0;
+  m->mlfq_pass = 0;
 
   // For schedulerLock,Unlock
-  MLFQ.is_locked = 0;
+  m->is_locked = 0;
+  m->locked_proc = 0;
+  m->leases = 0;
+  m->expired = 0;
+  m->held = 0;
+  m->delayed = 0;
+  m->maxdelayed = 0;
+  m->inherits = 0;
 
   // For MLFQ ticks
-  MLFQ.global_ticks = 0;
+  m->global_ticks = 0;
+
+  m->decisions = 0;
+  m->cycles = 0;
+  m->max_cycles = 0;
+  m->steals = 0;
+}
+
+// Queue index of a process, decided by its level and L2 priority.
+static int
+mlfq_qidx(struct proc *p)
+{
+  if(p->level < conf.nlevel - 1)
+    return p->level;
+  if(conf.l2policy == L2_POLICY_RR)
+    return conf.nlevel - 1;
+  return conf.nlevel - 1 + p->priority;
 }
 
 // Enqueue function for MLFQ
-// This function takes process struct pointer and level
+// This function takes process struct pointer and queue index
 int
-mlfq_enqueue(struct proc* proc, int level){
+mlfq_enqueue(struct mlfq *m, struct proc* proc, int q){
   
-  struct proc_queue_t *target = &MLFQ.queue[level];
+  struct proc_queue_t *target = &m->queue[q];
   
-  // maximum number of possible processes in the queue (of the level)
+  // maximum number of possible processes in the queue
   if (target->size == NPROC)
     return -1;
   
-  // if queue[level] has empty space
+  // if queue[q] has empty space
   int target_idx = (target->rear + 1) % NPROC;
   target->data[target_idx] = proc;
   target->rear = target_idx;
   ++target->size;
+  ++m->nready;
+  m->bitmap |= 1 << q;
   return 0;
 }
 
 // Dequeue function for MLFQ
-// level을 인자로 받아 level에 맞는 queue의 process를 꺼내서 리턴한다.
+// queue index를 인자로 받아 해당 queue의 process를 꺼내서 리턴한다.
 struct proc*
-mlfq_dequeue(int level){
+mlfq_dequeue(struct mlfq *m, int q){
   
   // target queue를 가져온다.
-  struct proc_queue_t *target = &MLFQ.queue[level];
+  struct proc_queue_t *target = &m->queue[q];
 
   // target이 비어있을 경우
   if (target->size == 0)
@@ -101,90 +175,253 @@ mlfq_dequeue(int level){
   struct proc* ret = target->data[target->front];
   target->data[target->front] = 0;
   target->front = (target->front + 1) % NPROC;
-  --target->size;
+  --m->nready;
+  if (--target->size == 0)
+    m->bitmap &= ~(1 << q);
 
   return ret;
 }
 
-// MLFQ lock
-// Turn on is_locked variables
-void
-mlfq_locking(struct proc* p){
-  MLFQ.is_locked=1;
-  MLFQ.queue[p->level].is_locked=1;
-  p->is_locked=1;
-}
-
-// MLFQ unlock
-// Turn off is_locked variables
-void
-mlfq_unlocking(struct proc* p){
-  MLFQ.is_locked=0;
-  MLFQ.queue[p->level].is_locked=0;
-  p->is_locked=0;
-}
-
 // push function for MLFQ
-// 해당하는 level의 queue의 맨 앞에 process를 넣는 함수
-// locked process가 lock이 풀릴 때만 사용된다.
-void mlfq_push(struct proc* proc, int level){
-  struct proc_queue_t *target = &MLFQ.queue[level];
+// 해당하는 queue의 맨 앞에 process를 넣는 함수
+// locked process가 다시 스케줄 되어야 할 때 사용된다.
+void mlfq_push(struct mlfq *m, struct proc* proc, int q){
+  struct proc_queue_t *target = &m->queue[q];
 
   int target_idx = (target->front-1+NPROC)%NPROC;
   target->data[target_idx] = proc;
-  target->front = (target->front-1+NPROC)%NPROC;
+  target->front = target_idx;
   ++target->size;
+  ++m->nready;
+  m->bitmap |= 1 << q;
 }
 
-// Priority boosting
-void
-mlfq_priority_boosting(void){
-  struct proc_queue_t *target = &MLFQ.queue[0];
-  struct proc *proc;
-  MLFQ.global_ticks = 0;
+// pop function for MLFQ
+// 해당하는 queue의 맨 뒤 process를 꺼내는 함수
+// 다른 CPU가 work stealing 할 때 사용된다.
+struct proc*
+mlfq_pop(struct mlfq *m, int q){
+  struct proc_queue_t *target = &m->queue[q];
+
+  if (target->size == 0)
+    return 0;
+
+  struct proc* ret = target->data[target->rear];
+  target->data[target->rear] = 0;
+  target->rear = (target->rear-1+NPROC)%NPROC;
+  --m->nready;
+  if (--target->size == 0)
+    m->bitmap &= ~(1 << q);
+
+  return ret;
+}
+
+// Number of processes in the MLFQ queues of m.
+static int
+mlfq_nqueued(struct mlfq *m)
+{
+  return m->nready - m->stride.size - m->edf.size;
+}
+
+// Process heaps: the stride heap is ordered by pass and the EDF
+// heap by deadline. Both wrap, so keys are compared by their
+// signed difference.
+static uint
+heap_key(struct proc *p)
+{
+  return p->class == SCHED_EDF ? p->edf_deadline : p->pass;
+}
+
+static int
+heap_before(struct proc *a, struct proc *b)
+{
+  return (int)(heap_key(a) - heap_key(b)) < 0;
+}
 
-  // L0 queue의 모든 것들을 모두 초기화한다.
-  for(int i = 0; i < target->size; ++i){
-    proc = mlfq_dequeue(0);
-    proc->priority = 3;
-    proc->time_quantum = 0;
+static void
+heap_swap(struct procheap *h, int i, int j)
+{
+  struct proc *t = h->data[i];
 
-    mlfq_enqueue(proc, 0);
+  h->data[i] = h->data[j];
+  h->data[j] = t;
+  h->data[i]->heapidx = i;
+  h->data[j]->heapidx = j;
+}
+
+static void
+heap_up(struct procheap *h, int i)
+{
+  while(i > 0 && heap_before(h->data[i], h->data[(i - 1) / 2])){
+    heap_swap(h, i, (i - 1) / 2);
+    i = (i - 1) / 2;
   }
+}
 
-  // L1, L2의 모든 process를 L0로 옮긴다.
-  for(int lev = 1; lev <= 2; ++lev){
-    target = &MLFQ.queue[lev];
+static void
+heap_down(struct procheap *h, int i)
+{
+  int l, min;
 
-    for(int i = 0; i < target->size; ++i){
-      proc = mlfq_dequeue(lev);
-      proc->priority = 3;
-      proc->time_quantum = 0;
-      proc->level = 0;
+  for(;;){
+    min = i;
+    l = 2 * i + 1;
+    if(l < h->size && heap_before(h->data[l], h->data[min]))
+      min = l;
+    if(l + 1 < h->size && heap_before(h->data[l + 1], h->data[min]))
+      min = l + 1;
+    if(min == i)
+      return;
+    heap_swap(h, i, min);
+    i = min;
+  }
+}
 
-      mlfq_enqueue(proc, 0);
-    }
+static void
+heap_push(struct procheap *h, struct proc *p)
+{
+  p->heapidx = h->size;
+  h->data[h->size++] = p;
+  heap_up(h, p->heapidx);
+}
+
+static void
+heap_remove(struct procheap *h, struct proc *p)
+{
+  int i = p->heapidx;
+
+  if(i != --h->size){
+    h->data[i] = h->data[h->size];
+    h->data[i]->heapidx = i;
+    heap_down(h, i);
+    heap_up(h, i);
   }
+  p->heapidx = -1;
 }
 
-// A function that removes zombie process from MLFQ and frees up the space
-void 
-mlfq_kill(struct proc *proc){
-  // Using target process's level, Access the target queue.
-  struct proc_queue_t *target = &MLFQ.queue[proc->level];
-
-  // Find target process's index from MLFQ
-  int idx;
-  for(idx = 0; idx < NPROC; ++idx){
-    if (target->data[idx] == proc){
+// Add a stride process to the heap. A process coming back from
+// sleep does not bank the time it missed: its pass starts no
+// earlier than the cpu's virtual time.
+static void
+stride_insert(struct mlfq *m, struct proc *p)
+{
+  if((int)(p->pass - m->vtime) < 0)
+    p->pass = m->vtime;
+  heap_push(&m->stride, p);
+  ++m->nready;
+}
+
+// Start the next job of EDF process p, one period after the last,
+// or one period from now if it fell behind by whole periods.
+static void
+edf_nextjob(struct mlfq *m, struct proc *p)
+{
+  p->edf_deadline += p->period;
+  if((int)(ticks - p->edf_deadline) >= 0)
+    p->edf_deadline = ticks + p->period;
+  p->budget = p->runtime;
+  m->jobs++;
+}
+
+// Queue an EDF process. wanted is set if it was runnable all along,
+// so a job that reached its deadline with budget left missed it.
+// A process that used up its budget waits for its next period.
+static void
+edf_insert(struct mlfq *m, struct proc *p, int wanted)
+{
+  if((int)(ticks - p->edf_deadline) >= 0){
+    if(wanted && p->budget > 0)
+      m->misses++;
+    edf_nextjob(m, p);
+  } else if(p->budget == 0){
+    m->throttled[m->nthrottled++] = p;
+    return;
+  }
+  heap_push(&m->edf, p);
+  ++m->nready;
+}
+
+// Pick the EDF process with the earliest deadline, after releasing
+// the throttled ones whose period began and rolling over the jobs
+// that missed their deadline while queued.
+static struct proc*
+edf_select(struct mlfq *m)
+{
+  struct proc *p;
+  int i;
+
+  for(i = 0; i < m->nthrottled; ){
+    p = m->throttled[i];
+    if((int)(ticks - p->edf_deadline) >= 0){
+      m->throttled[i] = m->throttled[--m->nthrottled];
+      edf_nextjob(m, p);
+      heap_push(&m->edf, p);
+      ++m->nready;
+    } else
+      i++;
+  }
+  while(m->edf.size > 0 && (int)(ticks - m->edf.data[0]->edf_deadline) >= 0){
+    p = m->edf.data[0];
+    m->misses++;
+    heap_remove(&m->edf, p);
+    edf_nextjob(m, p);
+    heap_push(&m->edf, p);
+  }
+  if(m->edf.size == 0)
+    return 0;
+  p = m->edf.data[0];
+  heap_remove(&m->edf, p);
+  --m->nready;
+  return p;
+}
+
+// Ticks until the first throttled EDF process of m may run again,
+// or 0 if there is none.
+// Caller must hold m->lock.
+static uint
+edf_next(struct mlfq *m)
+{
+  uint d, min = 0;
+  int i;
+
+  for(i = 0; i < m->nthrottled; i++){
+    d = m->throttled[i]->edf_deadline - ticks;
+    if((int)d <= 0)
+      return 1;
+    if(min == 0 || d < min)
+      min = d;
+  }
+  return min;
+}
+
+// A function that removes a process from the middle of its queue.
+// Used when a queued process changes queue without being scheduled.
+// Returns 1 if the process was in its queue, 0 otherwise.
+// Caller must hold m->lock, where m is the MLFQ of proc.
+int
+mlfq_remove(struct mlfq *m, struct proc *proc){
+  if(proc->class != SCHED_MLFQ){
+    if(proc->heapidx < 0)
+      return 0;
+    heap_remove(proc->class == SCHED_EDF ? &m->edf : &m->stride, proc);
+    --m->nready;
+    return 1;
+  }
+
+  int q = mlfq_qidx(proc);
+  struct proc_queue_t *target = &m->queue[q];
+
+  // Find target process's index from its queue
+  int i, idx = target->front;
+  for(i = 0; i < target->size; ++i){
+    if (target->data[idx] == proc)
       break;
-    }
+    idx = (idx + 1) % NPROC;
   }
 
   // parameter인 target process가 존재하지 않을 경우
-  if (idx == NPROC) return;
+  if (i == target->size) return 0;
 
-  // remove zombie process in MLFQ
   // target 프로세스를 기준으로 왼쪽의 process를 한 칸씩 오른쪽으로 옮긴다.
   int nxt; 
   while(idx != target->front){
@@ -197,20 +434,473 @@ mlfq_kill(struct proc *proc){
   }
 
   // front를 한 칸 옮기고 원래 front였던 자리는 0으로 초기화 한다.
-  target->data[target->front] = 0;
-  target->front = (target->front + 1) % NPROC;
-  --target->size;
+  mlfq_dequeue(m, q);
+  return 1;
+}
+
+// Put a process back in its queue: at the tail, or at the
+// front if it holds the schedulerLock so it is picked next.
+// Stride and EDF processes go to their heap.
+// Caller must hold m->lock.
+static void
+mlfq_insert(struct mlfq *m, struct proc *p)
+{
+  if(p->class == SCHED_EDF)
+    edf_insert(m, p, 0);
+  else if(p->class == SCHED_STRIDE)
+    stride_insert(m, p);
+  else if(p->is_locked)
+    mlfq_push(m, p, mlfq_qidx(p));
+  else
+    mlfq_enqueue(m, p, mlfq_qidx(p));
+}
+
+// Wake a halted cpu for work queued on cpu c: c itself if it is
+// idle, or an idle cpu to steal from c if c has a backlog.
+// Caller must have interrupts off.
+static void
+mlfq_kick(struct cpu *c)
+{
+  struct cpu *i;
+
+  // Pairs with the barrier in mlfq_idle: either we see the idle
+  // flag here, or the idle cpu sees the queued process.
+  __sync_synchronize();
+  if(c->idle){
+    if(c != mycpu())
+      lapicipi(c->apicid);
+    return;
+  }
+  if(c->mlfq.nready < 2)
+    return;
+  for(i = cpus; i < &cpus[ncpu]; i++){
+    if(i->idle && i != mycpu()){
+      lapicipi(i->apicid);
+      return;
+    }
+  }
+}
+
+// Make a process RUNNABLE and put it in its queue.
+// Caller must hold p->lock.
+static void
+mlfq_ready(struct proc *p)
+{
+  struct mlfq *m = mlfq_of(p);
+
+  p->readytsc = rdtsc();
+  acquire(&m->lock);
+  p->state = RUNNABLE;
+  mlfq_insert(m, p);
+  release(&m->lock);
+  mlfq_kick(&cpus[p->cpu]);
+}
+
+// Choose the cpu for a new process: the one with the
+// fewest runnable and running processes.
+// The loads are read without locks; a stale value
+// only makes the placement less even.
+static int
+mlfq_place(void)
+{
+  int i, load, best = 0, bestload = NPROC + 1;
+
+  for(i = 0; i < ncpu; ++i){
+    load = cpus[i].mlfq.nready + (cpus[i].proc != 0);
+    if(load < bestload){
+      best = i;
+      bestload = load;
+    }
+  }
+  return best;
+}
+
+// MLFQ lock
+// Turn on is_locked variables
+// and start a lease of conf.lease ticks.
+void
+mlfq_locking(struct proc* p){
+  struct mlfq *m = mlfq_of(p);
+
+  m->is_locked=1;
+  m->locked_proc=p;
+  p->is_locked=1;
+
+  m->lease_start = ticks;
+  m->lease_end = ticks + conf.lease;
+  m->lease_delayed = 0;
+  m->leases++;
+}
+
+// MLFQ unlock
+// Turn off is_locked variables of the locked process
+// and account the lease that ends.
+void
+mlfq_unlocking(struct mlfq *m){
+  if(m->locked_proc)
+    m->locked_proc->is_locked=0;
+  if(m->is_locked){
+    m->held += ticks - m->lease_start;
+    if(m->lease_delayed > m->maxdelayed)
+      m->maxdelayed = m->lease_delayed;
+  }
+  m->is_locked=0;
+  m->locked_proc=0;
+}
+
+// End the lease of m if it ran out of time.
+// The holder goes back to the tail of its queue like
+// any other process.
+// Caller must hold m->lock.
+static void
+mlfq_lease_check(struct mlfq *m)
+{
+  struct proc *p = m->locked_proc;
+
+  if(!m->is_locked || (int)(ticks - m->lease_end) < 0)
+    return;
+  m->expired++;
+  if(p->state == RUNNABLE && mlfq_remove(m, p)){
+    mlfq_unlocking(m);
+    mlfq_insert(m, p);
+  } else
+    mlfq_unlocking(m);
+}
+
+// Priority inheritance: the lease holder is blocked waiting for p,
+// so p runs next on its cpu, from the front of L0
+// (or, for a stride process, with the lowest pass).
+// Caller must hold p->lock.
+static void
+mlfq_inherit(struct proc *p)
+{
+  struct mlfq *m = mlfq_lock(p);
+
+  if(p->state == RUNNABLE && !p->is_locked && mlfq_remove(m, p)){
+    if(p->class == SCHED_EDF)
+      mlfq_insert(m, p);
+    else if(p->class == SCHED_STRIDE){
+      p->pass = m->vtime;
+      stride_insert(m, p);
+    } else {
+      p->level = 0;
+      p->time_quantum = 0;
+      mlfq_push(m, p, 0);
+    }
+    m->inherits++;
+  }
+  release(&m->lock);
+}
+
+// The running process is about to block on something held by
+// process pid. If it holds a lease, pid inherits its priority.
+void
+schedinherit(int pid)
+{
+  struct proc *p;
+
+  if(myproc() == 0 || !myproc()->is_locked || pid == 0)
+    return;
+  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(p->pid == pid){
+      mlfq_inherit(p);
+      release(&p->lock);
+      return;
+    }
+    release(&p->lock);
+  }
+}
+
+// Priority boosting
+// Moves every process of this MLFQ to L0 and resets it.
+// Caller must hold m->lock.
+void
+mlfq_priority_boosting(struct mlfq *m){
+  struct proc *p;
+  m->global_ticks = 0;
+
+  // L1, L2의 모든 process를 순서대로 L0 뒤로 옮긴다.
+  for(int q = 1; q < MLFQ_NQUEUE; ++q)
+    while((p = mlfq_dequeue(m, q)) != 0){
+      p->level = 0;
+      mlfq_insert(m, p);
+    }
+
+  // 이 CPU에 속한 실행 중이거나 잠든 process도 초기화한다.
+  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
+    if(p->state == UNUSED || mlfq_of(p) != m)
+      continue;
+    p->level = 0;
+    p->priority = 3;
+    p->time_quantum = 0;
+  }
+  traceevent(0, TRACE_BOOST);
+}
+
+// Demote a process whose time quantum ran out.
+// L0, L1인경우 level을 상승시키고 L2인경우 priority를 낮춘다. (단, 최소 0)
+static void
+mlfq_demote(struct proc *p)
+{
+  if(p->level < conf.nlevel - 1)
+    ++p->level;
+  else if(conf.l2policy == L2_POLICY_PRIORITY && p->priority > 0)
+    --p->priority;
+}
+
+// Take a process from the busiest other cpu: the tail of its
+// lowest-priority non-empty queue, i.e. the one it would run
+// last there.
+// The locked process is never stolen.
+// Caller must not hold any MLFQ lock, so two idle cpus
+// stealing from each other cannot deadlock.
+static struct proc*
+mlfq_steal(struct cpu *c)
+{
+  struct mlfq *m, *victim = 0;
+  struct proc *p = 0;
+  struct proc_queue_t *target;
+  int i;
+
+  // Stride and EDF processes stay on their cpu, so only the
+  // MLFQ queues count.
+  for(i = 0; i < ncpu; ++i){
+    m = &cpus[i].mlfq;
+    if(&cpus[i] == c || m->bitmap == 0)
+      continue;
+    if(victim == 0 || mlfq_nqueued(m) > mlfq_nqueued(victim))
+      victim = m;
+  }
+  if(victim == 0)
+    return 0;
+
+  acquire(&victim->lock);
+  if(victim->bitmap != 0){
+    int q = 31 - __builtin_clz(victim->bitmap);
+    target = &victim->queue[q];
+    p = target->data[target->rear];
+    if(p->is_locked)
+      p = 0;
+    else {
+      mlfq_pop(victim, q);
+      p->cpu = c - cpus;
+      c->mlfq.steals++;
+    }
+  }
+  release(&victim->lock);
+  return p;
+}
+
+// Nothing to run on cpu c: stop the periodic tick, arm the timer
+// for the next sleeper deadline and halt until an interrupt.
+// Busy cpus keep their tick, since quanta and the boost
+// period of the MLFQ are counted in ticks.
+static void
+mlfq_idle(struct cpu *c)
+{
+  unsigned long long edf;
+  uint wake, n;
+
+  cli();
+  c->idle = 1;
+  __sync_synchronize();
+  if(c->mlfq.nready == 0){
+    c->halts++;
+    wake = timernext();
+    // Throttled EDF processes must be back at their next period.
+    acquire(&c->mlfq.lock);
+    n = edf_next(&c->mlfq);
+    release(&c->mlfq.lock);
+    if(n){
+      edf = (unsigned long long)n * tsc_per_tick;
+      if(edf > 0xFFFFFFFF)
+        edf = 0xFFFFFFFF;
+      if(wake == 0 || edf < wake)
+        wake = edf;
+    }
+    lapiconeshot(wake);
+    // No interrupt is taken between sti and hlt, so a wakeup
+    // IPI sent after the check above still ends the halt.
+    asm volatile("sti; hlt");
+    cli();
+    lapicperiodic();
+  }
+  c->idle = 0;
+  sti();
+}
+
+// Pick the next process to run on cpu c and take it off its queue.
+// First the EDF process with the earliest deadline, if any can run.
+// Then the locked process if it is queued (it is always at the front
+// of its queue then) and its lease has not run out. Otherwise the
+// stride processes and the MLFQ as a whole take turns by pass: either
+// the stride process with the lowest pass, or the head of the lowest
+// non-empty MLFQ queue. O(log n) in the number of EDF and stride
+// processes.
+// Caller must hold c->mlfq.lock.
+static struct proc*
+mlfq_select(struct cpu *c)
+{
+  struct mlfq *m = &c->mlfq;
+  struct proc *p, *s;
+  struct proc_queue_t *target;
+
+  if((m->edf.size > 0 || m->nthrottled > 0) && (p = edf_select(m)) != 0)
+    return p;
+
+  mlfq_lease_check(m);
+  p = m->locked_proc;
+  if(m->is_locked){
+    if(p->class != SCHED_MLFQ){
+      if(mlfq_remove(m, p))
+        return p;
+    } else {
+      target = &m->queue[mlfq_qidx(p)];
+      if(target->size > 0 && target->data[target->front] == p)
+        return mlfq_dequeue(m, mlfq_qidx(p));
+    }
+  }
+
+  s = m->stride.size > 0 ? m->stride.data[0] : 0;
+  if(m->bitmap != 0){
+    // Like a stride process, the MLFQ banks no time while empty.
+    if((int)(m->mlfq_pass - m->vtime) < 0)
+      m->mlfq_pass = m->vtime;
+    if(s == 0 || (int)(m->mlfq_pass - s->pass) <= 0){
+      m->vtime = m->mlfq_pass;
+      m->mlfq_pass += STRIDE1 / MLFQ_TICKETS;
+      return mlfq_dequeue(m, __builtin_ctz(m->bitmap));
+    }
+  }
+  if(s == 0)
+    return 0;
+  mlfq_remove(m, s);
+  m->vtime = s->pass;
+  s->pass += s->stride;
+  return s;
+}
+
+// Account the tick process p just ran for and put it back
+// in its MLFQ if it is still RUNNABLE.
+// Returns why p stopped running, as a TRACE_* reason.
+// Caller must hold p->lock and the MLFQ lock of p.
+static int
+mlfq_update(struct proc *p)
+{
+  struct mlfq *m = mlfq_of(p);
+  int lev = p->level;
+  int reason = TRACE_YIELD;
+
+  if(p->state == SLEEPING)
+    reason = TRACE_SLEEP;
+  else if(p->state == ZOMBIE)
+    reason = TRACE_EXIT;
+
+  // The others waiting here were delayed by the holder's tick.
+  if(p->is_locked && p->state == RUNNABLE){
+    m->delayed += m->nready;
+    m->lease_delayed += m->nready;
+  }
+
+  // Stride and EDF processes have no level or quantum; they only
+  // count towards the boost period and the lease like the others.
+  // A full tick is charged to the budget of an EDF process.
+  if(p->class != SCHED_MLFQ){
+    if(p->state == RUNNABLE || p->is_locked)
+      m->global_ticks++;
+    if(p->is_locked && (p->state == ZOMBIE || m->global_ticks >= conf.boost))
+      mlfq_unlocking(m);
+    if(p->class == SCHED_EDF && p->state == ZOMBIE)
+      m->edf_util -= p->util;
+    if(p->state == RUNNABLE && p->class == SCHED_EDF){
+      if(p->budget > 0)
+        p->budget--;
+      edf_insert(m, p, 1);
+    } else if(p->state == RUNNABLE)
+      stride_insert(m, p);
+    if(m->global_ticks >= conf.boost)
+      mlfq_priority_boosting(m);
+    return reason;
+  }
+
+  // process가 정상적으로 끝났으면 time quantum, global_ticks을 상승시킨다.
+  if (p->state == RUNNABLE){
+    p->time_quantum++;
+    m->global_ticks++;
+  }
+  else if(p->is_locked == 1){
+    // 정상적으로 끝나지 않아도 locked process이면 global ticks를 상승시킨다.
+    m->global_ticks++;
+
+    // locked process가 zombie process인 경우
+    // 해당 process에 lock을 해제한다.
+    if(p->state == ZOMBIE)
+      mlfq_unlocking(m);
+  }
+
+  // whether current process is locked or not and ticks is 100 then run priority_boosting.
+  if(m->global_ticks >= conf.boost){
+    // if current process is locked, unlock it and
+    // put it at the front of L0 queue.
+    if(p->is_locked == 1){
+      mlfq_unlocking(m);
+      p->level = 0;
+      p->priority = 3;
+      p->time_quantum = 0;
+      if(p->state == RUNNABLE)
+        mlfq_push(m, p, 0);
+    }
+    // myproc이 time quantum을 다 썼으면 뒤로 보내고 boosting한다.
+    else if(p->state == RUNNABLE){
+      if(p->time_quantum >= conf.quantum[lev]){
+        mlfq_demote(p);
+        reason = TRACE_EXPIRE;
+      }
+      mlfq_enqueue(m, p, mlfq_qidx(p));
+    }
+
+    // Run priority boosting function.
+    mlfq_priority_boosting(m);
+    return reason;
+  }
+
+  if(p->state != RUNNABLE)
+    return reason;
+
+  // locked process는 다시 맨 앞에서 실행된다.
+  if(p->is_locked == 1){
+    mlfq_insert(m, p);
+    return reason;
+  }
+
+  // MLFQ is not locked and current process runs out of time quantums
+  // if level of current process is 0 or 1 then raises the level
+  // else process's priority down
+  if(m->is_locked == 0 && p->time_quantum >= conf.quantum[lev]){
+    p->time_quantum = 0;
+    mlfq_demote(p);
+    reason = TRACE_EXPIRE;
+  }
+
+  // For round robin
+  // 현재 process를 뒤로 보낸다.
+  mlfq_enqueue(m, p, mlfq_qidx(p));
+  return reason;
 }
 
 // schedulerLock
 // 비밀번호를 인자로 받아 비밀번호가 올바르면 해당 process에 lock을 건다.
+// lock은 process가 속한 CPU의 MLFQ에만 걸리고 다른 CPU는 계속 스케줄한다.
 void 
 schedulerLock(int password){
-  acquire(&ptable.lock);
+  struct mlfq *m = mlfq_of(myproc());
+  acquire(&m->lock);
+
   // MLFQ has already locked process
-  if (MLFQ.is_locked == 1) {
+  if (m->is_locked == 1) {
     cprintf("Duplicate Lock\n");
-    release(&ptable.lock);
+    release(&m->lock);
     kill(myproc()->pid);
     return;
   }
@@ -218,49 +908,52 @@ schedulerLock(int password){
   // password is not correct 
   if(password != PASSWORD){
     cprintf("%d %d %d\n", myproc()->pid, myproc()->time_quantum, myproc()->level);
-    release(&ptable.lock);
+    release(&m->lock);
     kill(myproc()->pid);
     return;
   }
 
   // password is correct!
-  MLFQ.global_ticks = 0;
+  m->global_ticks = 0;
   mlfq_locking(myproc());
-  release(&ptable.lock);
+  traceevent(myproc(), TRACE_LOCK);
+  release(&m->lock);
 }
 
 // schedulerUnlock
 // 비밀번호를 인자로 받아 비밀번호가 올바르면 해당 process에 lock을 푼다.
 void
 schedulerUnlock(int password){
+  struct mlfq *m = mlfq_of(myproc());
 
-  acquire(&ptable.lock);
+  acquire(&m->lock);
 
   // MLFQ has already locked process
-  if(MLFQ.is_locked == 0) {
+  if(m->is_locked == 0) {
     cprintf("Duplicate Unlock\n");
-    release(&ptable.lock);
+    release(&m->lock);
     return;
   }
 
   // password is not correct 
   if(password != PASSWORD){
     cprintf("%d %d %d\n", myproc()->pid, myproc()->time_quantum, myproc()->level);
-    mlfq_unlocking(myproc());
-    release(&ptable.lock);
+    mlfq_unlocking(m);
+    release(&m->lock);
     kill(myproc()->pid);
     return;
   }
 
   // password is correct!
-  mlfq_unlocking(myproc());
-  mlfq_dequeue(myproc()->level);
+  // The caller is running, so it is not in any queue; it goes back
+  // to L0 when it yields.
+  mlfq_unlocking(m);
   myproc()->level = 0;
   myproc()->time_quantum = 0;
   myproc()->priority = 3;
-  mlfq_push(myproc(), 0);
+  traceevent(myproc(), TRACE_UNLOCK);
 
-  release(&ptable.lock);
+  release(&m->lock);
 }
 
 // process의 level을 return하는 함수
@@ -271,6 +964,231 @@ getLevel(void){
   return cur_level;
 }
 
+// Snapshot of the scheduling decision cost counters,
+// summed over all cpus.
+// Each cpu only updates its own counters, so they are read without locks.
+void
+getSchedStat(struct schedstat *st)
+{
+  struct mlfq *m;
+  int i;
+
+  memset(st, 0, sizeof(*st));
+  for(i = 0; i < ncpu; ++i){
+    m = &cpus[i].mlfq;
+    st->decisions += m->decisions;
+    st->cycles += m->cycles;
+    st->steals += m->steals;
+    if(m->max_cycles > st->max_cycles)
+      st->max_cycles = m->max_cycles;
+  }
+}
+
+// Snapshot of the schedulerLock lease counters, summed over all cpus.
+// Read without locks; the counters are only statistics.
+void
+getLeaseStat(struct leasestat *st)
+{
+  struct mlfq *m;
+  int i;
+
+  memset(st, 0, sizeof(*st));
+  for(i = 0; i < ncpu; ++i){
+    m = &cpus[i].mlfq;
+    st->leases += m->leases;
+    st->expired += m->expired;
+    st->held += m->held;
+    st->delayed += m->delayed;
+    st->inherits += m->inherits;
+    if(m->maxdelayed > st->maxdelayed)
+      st->maxdelayed = m->maxdelayed;
+  }
+}
+
+// Add the counters of lk to lc.
+static void
+lockcount_add(struct lockcount *lc, struct spinlock *lk)
+{
+  lc->acquire += lk->nacquire;
+  lc->spin += lk->nspin;
+}
+
+// Snapshot of the contention counters of the process table locks.
+// Read without locks; the counters are only statistics.
+void
+getLockStat(struct lockstat *st)
+{
+  struct proc *p;
+  int i;
+
+  memset(st, 0, sizeof(*st));
+  lockcount_add(&st->ptable, &ptable.lock);
+  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+    lockcount_add(&st->proc, &p->lock);
+  for(i = 0; i < ncpu; ++i)
+    lockcount_add(&st->mlfq, &cpus[i].mlfq.lock);
+  for(i = 0; i < NSLEEPQ; ++i)
+    lockcount_add(&st->sleepq, &sleepq[i].lock);
+}
+
+// Copy the MLFQ parameters to c.
+void
+getSchedConf(struct schedconf *c)
+{
+  struct mlfq *m = &cpus[0].mlfq;
+
+  acquire(&m->lock);
+  *c = conf;
+  release(&m->lock);
+}
+
+// Replace the MLFQ parameters with c.
+// The queues of every cpu are rebuilt for the new levels by
+// boosting all processes to L0, so the change applies at once.
+// Returns -1 if c is not valid.
+int
+setSchedConf(struct schedconf *c)
+{
+  int i;
+
+  if(c->nlevel < 2 || c->nlevel > MLFQ_MAXLEVEL || c->boost < 1 || c->lease < 1)
+    return -1;
+  if(c->l2policy != L2_POLICY_PRIORITY && c->l2policy != L2_POLICY_RR)
+    return -1;
+  for(i = 0; i < c->nlevel; ++i)
+    if(c->quantum[i] < 1)
+      return -1;
+
+  // Nobody else holds two MLFQ locks, so taking them all is safe.
+  for(i = 0; i < ncpu; ++i)
+    acquire(&cpus[i].mlfq.lock);
+  conf = *c;
+  for(i = 0; i < ncpu; ++i)
+    mlfq_priority_boosting(&cpus[i].mlfq);
+  for(i = ncpu - 1; i >= 0; --i)
+    release(&cpus[i].mlfq.lock);
+  return 0;
+}
+
+// Move process pid to the stride class with the given tickets,
+// or back to the MLFQ (at L0) if tickets is 0.
+// Stride processes are never stolen, so shares are kept per cpu;
+// returns the cpu of the process, or -1 if there is no such
+// process, it is an EDF process or tickets is out of range.
+int
+setTickets(int pid, int tickets)
+{
+  struct proc *p;
+  struct mlfq *m;
+  int queued;
+
+  if(tickets < 0 || tickets > STRIDE_MAXTICKETS)
+    return -1;
+  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(p->pid == pid && p->state != UNUSED){
+      if(p->class == SCHED_EDF){
+        release(&p->lock);
+        return -1;
+      }
+      m = mlfq_lock(p);
+      queued = p->state == RUNNABLE && mlfq_remove(m, p);
+      if(tickets == 0){
+        p->class = SCHED_MLFQ;
+        p->level = 0;
+        p->time_quantum = 0;
+      } else {
+        if(p->class != SCHED_STRIDE)
+          p->pass = m->vtime;
+        p->class = SCHED_STRIDE;
+        p->stride = STRIDE1 / tickets;
+      }
+      p->tickets = tickets;
+      if(queued)
+        mlfq_insert(m, p);
+      release(&m->lock);
+      release(&p->lock);
+      return p->cpu;
+    }
+    release(&p->lock);
+  }
+  return -1;
+}
+
+// Put the calling process in the EDF class: in every period of
+// period ticks it may run for runtime ticks, ahead of the MLFQ and
+// stride processes of its cpu. Admission fails if the EDF
+// utilization of the cpu would go above EDF_MAXUTIL.
+// setDeadline(0, 0) puts the process back in the MLFQ.
+// Returns 0, or -1 if the process is not admitted.
+int
+setDeadline(int period, int runtime)
+{
+  struct proc *p = myproc();
+  struct mlfq *m;
+  uint util = 0;
+
+  if(period != 0 || runtime != 0){
+    if(period < 1 || period > EDF_MAXPERIOD || runtime < 1 || runtime > period)
+      return -1;
+    // In per mille, rounded up: a task that needs any time must
+    // not count as none, and admission errs on the safe side.
+    util = (runtime * 1000 + period - 1) / period;
+  }
+
+  acquire(&p->lock);
+  m = mlfq_lock(p);
+  if(p->class == SCHED_EDF)
+    m->edf_util -= p->util;
+  if(m->edf_util + util > EDF_MAXUTIL){
+    if(p->class == SCHED_EDF)
+      m->edf_util += p->util;
+    m->rejected++;
+    release(&m->lock);
+    release(&p->lock);
+    return -1;
+  }
+
+  if(period == 0){
+    p->class = SCHED_MLFQ;
+    p->level = 0;
+    p->time_quantum = 0;
+  } else {
+    m->edf_util += util;
+    m->admitted++;
+    m->jobs++;
+    p->class = SCHED_EDF;
+    p->period = period;
+    p->runtime = runtime;
+    p->util = util;
+    p->edf_deadline = ticks + period;
+    p->budget = runtime;
+  }
+  release(&m->lock);
+  release(&p->lock);
+  return 0;
+}
+
+// Snapshot of the EDF counters, summed over all cpus.
+// Read without locks; the counters are only statistics.
+void
+getEDFStat(struct edfstat *st)
+{
+  struct mlfq *m;
+  int i;
+
+  memset(st, 0, sizeof(*st));
+  for(i = 0; i < ncpu; ++i){
+    m = &cpus[i].mlfq;
+    st->admitted += m->admitted;
+    st->rejected += m->rejected;
+    st->jobs += m->jobs;
+    st->misses += m->misses;
+    if(m->edf_util > st->maxutil)
+      st->maxutil = m->edf_util;
+  }
+}
+
 // 특정 pid의 process의 priority를 변경하는 함수
 // L0, L1, L2 어디에 있던지 사용가능.
 void 
@@ -282,17 +1200,26 @@ setPriority(int pid, int priority){
     cprintf("This priority %d is not allowed in MLFQ\n", priority);
     return;
   }
-  acquire(&ptable.lock);
-
   // 해당 pid를 가진 process를 탐색후 변경
   // 없는 경우 그냥 종료한다.
-  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+  // 대기 중인 L2 process는 새 priority의 queue로 옮긴다.
+  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
+    acquire(&p->lock);
     if (p->pid == pid){
-      p->priority = priority;
-      break;
-    }  
+      struct mlfq *m = mlfq_lock(p);
 
-  release(&ptable.lock);
+      if (p->level == conf.nlevel - 1 && mlfq_remove(m, p)){
+        p->priority = priority;
+        mlfq_insert(m, p);
+      }
+      else
+        p->priority = priority;
+      release(&m->lock);
+      release(&p->lock);
+      break;
+    }
+    release(&p->lock);
+  }
 }
 
 static struct proc *initproc;
@@ -301,16 +1228,31 @@ int nextpid = 1;
 extern void forkret(void);
 extern void trapret(void);
 
-static void wakeup1(void *chan);
-
 void
 pinit(void)
 {
+  struct proc *p;
+
   initlock(&ptable.lock, "ptable");
+  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+    initlock(&p->lock, "proc");
+  for(int i = 0; i < NSLEEPQ; ++i)
+    initlock(&sleepq[i].lock, "sleepq");
   
   // for mlfq
   // mlfq initalization part
-  mlfq_initalization();
+  for(int i = 0; i < NCPU; ++i){
+    initlock(&cpus[i].mlfq.lock, "mlfq");
+    mlfq_initalization(&cpus[i].mlfq);
+  }
+
+  // 기본 설정: 3 level, time quantum 2 * lev + 4, 100 tick마다 boosting
+  conf.nlevel = MLFQ_LEVEL;
+  for(int lev = 0; lev < MLFQ_MAXLEVEL; ++lev)
+    conf.quantum[lev] = 2 * lev + 4;
+  conf.boost = 100;
+  conf.l2policy = L2_POLICY_PRIORITY;
+  conf.lease = 100;
 }
 
 // Must be called with interrupts disabled
@@ -363,36 +1305,35 @@ allocproc(void)
   struct proc *p;
   char *sp;
 
-  acquire(&ptable.lock);
-
-  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
+    acquire(&p->lock);
     if(p->state == UNUSED)
       goto found;
-
-  release(&ptable.lock);
+    release(&p->lock);
+  }
   return 0;
 
 found:
   p->state = EMBRYO;
-  p->pid = nextpid++;
+  p->pid = __sync_fetch_and_add(&nextpid, 1);
 
   // for MLFQ
   p->level = 0;
   p->is_locked = 0;
   p->priority = 3;
+  p->class = SCHED_MLFQ;
+  p->tickets = 0;
+  p->heapidx = -1;
   p->time_quantum = 0;
+  p->cpu = mlfq_place();
 
-  // mlfq에 자리가 없으면 종료한다.
-  if(mlfq_enqueue(p, p->level) != 0){
-    release(&ptable.lock);
-    return 0;
-  }
-
-  release(&ptable.lock);
+  release(&p->lock);
 
   // Allocate kernel stack.
   if((p->kstack = kalloc()) == 0){
+    acquire(&p->lock);
     p->state = UNUSED;
+    release(&p->lock);
     return 0;
   }
   sp = p->kstack + KSTACKSIZE;
@@ -445,11 +1386,11 @@ userinit(void)
   // run this process. the acquire forces the above
   // writes to be visible, and the lock is also needed
   // because the assignment might not be atomic.
-  acquire(&ptable.lock);
+  acquire(&p->lock);
 
-  p->state = RUNNABLE;
+  mlfq_ready(p);
 
-  release(&ptable.lock);
+  release(&p->lock);
 }
 
 // Grow current process's memory by n bytes.
@@ -492,11 +1433,12 @@ fork(void)
   if((np->pgdir = copyuvm(curproc->pgdir, curproc->sz)) == 0){
     kfree(np->kstack);
     np->kstack = 0;
+    acquire(&np->lock);
     np->state = UNUSED;
+    release(&np->lock);
     return -1;
   }
   np->sz = curproc->sz;
-  np->parent = curproc;
   *np->tf = *curproc->tf;
 
   // Clear %eax so that fork returns 0 in the child.
@@ -512,11 +1454,13 @@ fork(void)
   pid = np->pid;
 
   acquire(&ptable.lock);
-
-  np->state = RUNNABLE;
-
+  np->parent = curproc;
   release(&ptable.lock);
 
+  acquire(&np->lock);
+  mlfq_ready(np);
+  release(&np->lock);
+
   return pid;
 }
 
@@ -549,17 +1493,21 @@ exit(void)
   acquire(&ptable.lock);
 
   // Parent might be sleeping in wait().
-  wakeup1(curproc->parent);
+  // It cannot see us before we are a zombie because
+  // it also holds ptable.lock while looking.
+  wakeup(curproc->parent);
 
   // Pass abandoned children to init.
   for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
     if(p->parent == curproc){
       p->parent = initproc;
-      if(p->state == ZOMBIE)
-        wakeup1(initproc);
+      wakeup(initproc);
     }
   }
 
+  acquire(&curproc->lock);
+  release(&ptable.lock);
+
   // Jump into the scheduler, never to return.
   curproc->state = ZOMBIE;
   sched();
@@ -583,10 +1531,10 @@ wait(void)
       if(p->parent != curproc)
         continue;
       havekids = 1;
+      // Holding p->lock also waits for the scheduler to
+      // finish switching away from an exiting child.
+      acquire(&p->lock);
       if(p->state == ZOMBIE){
-
-        // ZOMBIE가 발견되면 MLFQ내에서 지워버린다.
-	      mlfq_kill(p);
         // Found one.
         pid = p->pid;
         kfree(p->kstack);
@@ -597,9 +1545,14 @@ wait(void)
         p->name[0] = 0;
         p->killed = 0;
         p->state = UNUSED;
+        release(&p->lock);
         release(&ptable.lock);
         return pid;
       }
+      // A lease holder waiting for its children lets them run first.
+      if(curproc->is_locked)
+        mlfq_inherit(p);
+      release(&p->lock);
     }
 
     // No point waiting if we don't have any children.
@@ -608,85 +1561,11 @@ wait(void)
       return -1;
     }
 
-    // Wait for children to exit.  (See wakeup1 call in proc_exit.)
+    // Wait for children to exit.  (See wakeup call in proc_exit.)
     sleep(curproc, &ptable.lock);  //DOC: wait-sleep
   }
 }
 
-// MLFQ에 locked process가 없는 경우 runnable한 process를 찾기 위한 함수
-// return 값은 process의 주소이다.
-struct proc*
-find_runnable_proc(void)
-{
-  // 사용될 변수 초기화
-  struct proc *r_proc = 0;
-  int lev = 0, pid = -1, priority = 4;
-
-  struct proc_queue_t *traversal;
-  
-  // while문을 돌면서 runnable한 process를 탐색한다.
-  while(lev < MLFQ_LEVEL) {
-    traversal = &MLFQ.queue[lev];
-    
-    // 해당 level을 가진 queue에 process가 없을 경우
-    if(traversal->size == 0){
-      ++lev;
-      continue;
-    }
-
-    // circular queue이므로 L0, L1인 경우 한바퀴를 돌면서 runnable한 process를 탐색한다.
-    if(lev < 2){
-      for(int i = 0; i < traversal->size; ++i){
-        r_proc = traversal->data[traversal->front];
-        if(r_proc->state == RUNNABLE){
-          return r_proc;
-        }
-        mlfq_dequeue(lev);
-        mlfq_enqueue(r_proc, lev);
-      }
-    }
-
-    // level 2 queue인경우
-    // priority를 max_priority + 1로 잡고 순회하면서
-    // FCFS, priority 기준으로 적절한 process를 탐색한다.
-    else{
-      struct proc * temp;
-      pid = -1, priority = 4;
-      for(int i = 0; i < traversal->size; ++i){
-        int idx = (traversal->front+i)%NPROC;
-        temp = traversal->data[idx];
-        if(temp->state != RUNNABLE) continue;
-        if(priority > temp->priority){
-          priority = temp->priority;
-          pid = temp->pid;
-        }
-      }
-
-      // 발견하지 못했을 경우
-      if (pid == -1) 
-        break;
-
-      // 발견한 process가 맨 앞에 오도록 circular queue를 회전시킨다.
-      r_proc = traversal->data[traversal->front];
-      while(pid != r_proc->pid){
-        mlfq_dequeue(lev);
-        mlfq_enqueue(r_proc, lev);
-        r_proc = traversal->data[traversal->front];
-      }
-    }
-
-    // runnable한 process를 발견했으면 return 한다.
-    if (r_proc->state == RUNNABLE) {
-      return r_proc;
-    }
-
-    // runnable한 process가 없을 경우
-    ++lev;
-  }
-
-  return 0;
-}
-
 //PAGEBREAK: 42
 // Per-CPU process scheduler.
 // Each CPU calls scheduler() after setting itself up.
@@ -698,151 +1577,78 @@ find_runnable_proc(void)
 void
 scheduler(void)
 {
-  struct proc_queue_t *traversal;
   struct proc *p;
   struct cpu *c = mycpu();
+  struct mlfq *m = &c->mlfq;
+  struct schedtrace t;
+  unsigned long long start;
+  uint cost;
   c->proc = 0;
   
   for(;;){
     // Enable interrupts on this processor.
     sti();
 
-    // Loop over process table looking for process to run.
-    acquire(&ptable.lock);
-    
-    // MLFQ Scheduling
-    // proc initialization
-    p = 0;
-    // MLFQ has locked process
-    if(MLFQ.is_locked == 1){
-      // Find queue's level that is locked
-      int lev;
-      for(lev = 0; lev < MLFQ_LEVEL; ++lev){
-        traversal = &MLFQ.queue[lev];
-        if(traversal->is_locked == 1) break;
-      }
-      
-      // is_locked가 켜져있는 process를 탐색할 때까지 회전시킨다.
-      for(int i = 0; i < traversal->size; i++){
-        p = traversal->data[traversal->front];
-        if(p->is_locked == 1)
-          break;
-        
-        mlfq_dequeue(lev);
-        mlfq_enqueue(p, lev);
-      }
-
-      // locked process가 zombie process인 경우
-      // 해당 process에 lock을 해제한다.
-      if (p->state == ZOMBIE){
-        mlfq_unlocking(p);
-        release(&ptable.lock);
-        continue;
-      }
-    }
-    // MLFQ has no locked process.
-    else {
-      // runnable한 process를 찾는다.
-      p = find_runnable_proc();
+    // Pick the next process to run from this cpu's MLFQ,
+    // or steal one if it is empty.
+    start = rdtsc();
+    acquire(&m->lock);
+    p = mlfq_select(c);
+    release(&m->lock);
+    if(p == 0)
+      p = mlfq_steal(c);
+    if(p == 0){
+      mlfq_idle(c);
+      continue;
     }
 
     // process가 존재하는 경우
+    // It is off every queue now, so no other cpu can pick it.
     if (p != 0) {
+      cost = rdtsc() - start;
+      m->decisions++;
+      m->cycles += cost;
+      if(cost > m->max_cycles)
+        m->max_cycles = cost;
+
       // Switch to chosen process.  It is the process's job
-      // to release ptable.lock and then reacquire it
+      // to release p->lock and then reacquire it
       // before jumping back to us.
-
+      acquire(&p->lock);
       c->proc = p;
       switchuvm(p);
       p->state = RUNNING;
 
+      memset(&t, 0, sizeof(t));
+      t.pid = p->pid;
+      t.level = p->level;
+      t.priority = p->priority;
+      t.quantum = p->time_quantum;
+      start = rdtsc();
+      t.wait = start - p->readytsc;
+
       swtch(&(c->scheduler), p->context);
       switchkvm();
 
-      int lev = p->level;
+      p->readytsc = rdtsc();
+      t.run = p->readytsc - start;
 
-      // process가 정상적으로 끝났으면 time quantum, global_ticks을 상승시킨다.
-      if (p->state == RUNNABLE){        
-        p->time_quantum++;
-        MLFQ.global_ticks++;
-      }
-      else if(p->is_locked == 1){
-        // 정상적으로 끝나지 않아도 locked process이면 global ticks를 상승시킨다.
-        MLFQ.global_ticks++;
-      }
-      
-      // whether current process is locked or not and ticks is 100 then run priority_boosting.
-      if(MLFQ.global_ticks >= 100){
-        int flag = 0;
-
-        // if current process is locked, then the flag value sets 1
-        if(p->is_locked == 1) {
-          flag = 1;
-          // MLFQ Unlocking
-          mlfq_unlocking(p);
-        }
-
-        // Remove the current process from MLFQ and Enqueue this process in L0 queue
-        if (flag == 1){
-          mlfq_dequeue(lev);
-          
-          p->level=0;
-          p->priority=3;
-          p->time_quantum=0;
-          mlfq_push(p, 0);
-        }
-        // myproc이 time quantum을 다 썼으면 뒤로 보내고 boosting한다.
-        else if (p->time_quantum >= 2 * lev + 4){
-          if(lev < 2){
-              ++p->level;
-          }
-          else{
-            int priority = p->priority ? p->priority - 1 : 0;
-            p->priority = priority;
-          }
-          mlfq_dequeue(lev);
-          mlfq_enqueue(p, p->level);
-        }
-        // Run priority boosting function.
-
-        mlfq_priority_boosting();
-      }
-      // MLFQ is not locked and current process runs out of time quantums
-      // if level of current process is 0 or 1 then raises the level
-      // else process's priority down
-      else if (MLFQ.is_locked == 0){
-
-        // time quantum을 다 사용하였는지 check
-        if (p->time_quantum >= 2 * lev + 4){
-          p->time_quantum = 0;
-
-          // L0, L1인경우 level을 상승시킨다.
-          if(lev < 2){
-              ++p->level;
-          }
-
-          // L2인경우 priority를 낮춘다. (단, 최소 0)
-          else{
-            int priority = p->priority ? p->priority - 1 : 0;
-            p->priority = priority;
-          }
-        }
-
-        // For round robin
-        // 현재 process를 뒤로 보낸다.
-        mlfq_dequeue(lev);
-        mlfq_enqueue(p, p->level);
-      }
+      // time quantum을 갱신하고 runnable하면 queue에 다시 넣는다.
+      acquire(&m->lock);
+      t.reason = mlfq_update(p);
+      release(&m->lock);
+      tracesched(&t);
+      mlfq_kick(c);
 
       // Process is done running for now.
       // It should have changed its p->state before coming back.
       c->proc = 0;
+      release(&p->lock);
     }
-    release(&ptable.lock);
   }
 }
 
-// Enter scheduler.  Must hold only ptable.lock
+// Enter scheduler.  Must hold only p->lock
 // and have changed proc->state. Saves and restores
 // intena because intena is a property of this
 // kernel thread, not this CPU. It should
@@ -855,8 +1661,8 @@ sched(void)
   int intena;
   struct proc *p = myproc();
 
-  if(!holding(&ptable.lock))
-    panic("sched ptable.lock");
+  if(!holding(&p->lock))
+    panic("sched p->lock");
   if(mycpu()->ncli != 1)
     panic("sched locks");
   if(p->state == RUNNING)
@@ -872,10 +1678,12 @@ sched(void)
 void
 yield(void)
 {
-  acquire(&ptable.lock);  //DOC: yieldlock
-  myproc()->state = RUNNABLE;
+  struct proc *p = myproc();
+
+  acquire(&p->lock);  //DOC: yieldlock
+  p->state = RUNNABLE;
   sched();
-  release(&ptable.lock);
+  release(&p->lock);
 }
 
 // A fork child's very first scheduling by scheduler()
@@ -884,8 +1692,8 @@ void
 forkret(void)
 {
   static int first = 1;
-  // Still holding ptable.lock from scheduler.
-  release(&ptable.lock);
+  // Still holding p->lock from scheduler.
+  release(&myproc()->lock);
 
   if (first) {
     // Some initialization functions must be run in the context
@@ -905,6 +1713,7 @@ void
 sleep(void *chan, struct spinlock *lk)
 {
   struct proc *p = myproc();
+  struct sleepq *sq = sleepq_of(chan);
   
   if(p == 0)
     panic("sleep");
@@ -912,18 +1721,20 @@ sleep(void *chan, struct spinlock *lk)
   if(lk == 0)
     panic("sleep without lk");
 
-  // Must acquire ptable.lock in order to
-  // change p->state and then call sched.
-  // Once we hold ptable.lock, we can be
-  // guaranteed that we won't miss any wakeup
-  // (wakeup runs with ptable.lock locked),
-  // so it's okay to release lk.
-  if(lk != &ptable.lock){  //DOC: sleeplock0
-    acquire(&ptable.lock);  //DOC: sleeplock1
-    release(lk);
-  }
-  // Go to sleep.
+  // Must join the bucket of chan and acquire p->lock
+  // before releasing lk. Once we are in the bucket
+  // holding p->lock, wakeup (which runs with the bucket
+  // lock held and then takes p->lock) can only find us
+  // after sched() is done, so it's okay to release lk.
+  acquire(&sq->lock);  //DOC: sleeplock1
   p->chan = chan;
+  p->sleepnext = sq->head;
+  sq->head = p;
+  acquire(&p->lock);
+  release(&sq->lock);
+  release(lk);
+
+  // Go to sleep.
   p->state = SLEEPING;
 
   sched();
@@ -932,32 +1743,41 @@ sleep(void *chan, struct spinlock *lk)
   p->chan = 0;
 
   // Reacquire original lock.
-  if(lk != &ptable.lock){  //DOC: sleeplock2
-    release(&ptable.lock);
-    acquire(lk);
-  }
+  release(&p->lock);
+  acquire(lk);
 }
 
 //PAGEBREAK!
-// Wake up all processes sleeping on chan.
-// The ptable lock must be held.
+// Wake up processes sleeping on chan: all of them if
+// only is zero, otherwise just that one.
+// The woken processes are unlinked from the bucket.
 static void
-wakeup1(void *chan)
+wakeup1(void *chan, struct proc *only)
 {
-  struct proc *p;
+  struct sleepq *sq = sleepq_of(chan);
+  struct proc **pp, *p;
 
-  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++)
-    if(p->state == SLEEPING && p->chan == chan)
-      p->state = RUNNABLE;
+  acquire(&sq->lock);
+  for(pp = &sq->head; (p = *pp) != 0; ){
+    if(p->chan != chan || (only && p != only)){
+      pp = &p->sleepnext;
+      continue;
+    }
+    acquire(&p->lock);
+    *pp = p->sleepnext;
+    p->sleepnext = 0;
+    if(p->state == SLEEPING)
+      mlfq_ready(p);
+    release(&p->lock);
+  }
+  release(&sq->lock);
 }
 
 // Wake up all processes sleeping on chan.
 void
 wakeup(void *chan)
 {
-  acquire(&ptable.lock);
-  wakeup1(chan);
-  release(&ptable.lock);
+  wakeup1(chan, 0);
 }
 
 // Kill the process with the given pid.
@@ -967,19 +1787,24 @@ int
 kill(int pid)
 {
   struct proc *p;
+  void *chan;
 
-  acquire(&ptable.lock);
   for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
+    acquire(&p->lock);
     if(p->pid == pid){
       p->killed = 1;
+      chan = p->state == SLEEPING ? p->chan : 0;
+      release(&p->lock);
       // Wake process from sleep if necessary.
-      if(p->state == SLEEPING)
-        p->state = RUNNABLE;
-      release(&ptable.lock);
+      // The bucket lock comes before p->lock, so this is
+      // done after releasing it; if p woke up meanwhile,
+      // it is no longer in the bucket and is left alone.
+      if(chan)
+        wakeup1(chan, p);
       return 0;
     }
+    release(&p->lock);
   }
-  release(&ptable.lock);
   return -1;
 }
 
@@ -1,3 +1,95 @@
+// MLFQ LEVEL (default; the number of levels is set at runtime,
+// up to MLFQ_MAXLEVEL, see schedconf.h)
+#define MLFQ_LEVEL 3
+// Number of priorities in L2 queue (0 is scheduled first)
+#define L2_PRIORITY 4
+// Run queues: one per level above the last, and one per L2 priority
+#define MLFQ_NQUEUE (MLFQ_MAXLEVEL - 1 + L2_PRIORITY)
+
+// Scheduling classes.
+// EDF processes run first, by earliest deadline, within the
+// runtime they were admitted for in each period.
+// Stride processes get a CPU share proportional to their tickets;
+// the MLFQ as a whole holds MLFQ_TICKETS on each cpu.
+enum schedclass { SCHED_MLFQ, SCHED_STRIDE, SCHED_EDF };
+#define STRIDE1 (1 << 20)
+#define MLFQ_TICKETS 100
+#define STRIDE_MAXTICKETS 10000
+// Most EDF utilization admitted on a cpu, in per mille
+#define EDF_MAXUTIL 900
+#define EDF_MAXPERIOD 100000
+
+// Min-heap of processes on their scheduling key
+// (pass for stride, deadline for EDF).
+struct procheap {
+  struct proc *data[NPROC];
+  int size;
+};
+
+// Queue type for process
+struct proc_queue_t {
+  struct proc* data[NPROC];
+  
+  // for traversal
+  int front;
+  int rear;
+  int size;
+};
+
+// MLFQ structure
+// 3-Level feedback queue, one per CPU.
+// Only RUNNABLE processes are kept in the queues. A process leaves its
+// queue when the scheduler picks it and goes back on yield or wakeup.
+// lock protects the queues and the level, priority, time_quantum
+// and is_locked of the processes owned by this MLFQ.
+struct mlfq {
+  struct spinlock lock;
+  // queue[0], queue[1] are L0, L1.
+  // queue[nlevel - 1 + p] is L2 (the last level) with priority p.
+  struct proc_queue_t queue[MLFQ_NQUEUE];
+  // Runnable stride processes
+  struct procheap stride;
+  uint vtime;                  // pass of the last client picked
+  uint mlfq_pass;              // pass of the MLFQ class
+  // Runnable EDF processes, and those out of budget
+  // until their next period
+  struct procheap edf;
+  struct proc *throttled[NPROC];
+  int nthrottled;
+  uint edf_util;               // Admitted utilization, per mille
+  // EDF counters (see edfstat.h)
+  uint admitted;
+  uint rejected;
+  uint jobs;
+  uint misses;
+  // Bit q is set iff queue[q] is not empty, so the low bits are the
+  // per-level occupancy and the high bits the per-L2-priority one.
+  // The lowest set bit is the queue to be scheduled next.
+  uint bitmap;
+  int nready;                  // Number of queued processes, in every class
+  // is_locked for schedulerLock, Unlock
+  // The lock is a lease on this cpu that ends at lease_end.
+  int is_locked;
+  struct proc *locked_proc;
+  uint lease_start;
+  uint lease_end;
+  uint lease_delayed;          // delayed during the current lease
+  // lease counters (see leasestat.h)
+  uint leases;
+  uint expired;
+  uint held;
+  uint delayed;
+  uint maxdelayed;
+  uint inherits;
+  // global_ticks is tick for this CPU's MLFQ scheduler
+  uint global_ticks;
+  // cost of scheduling decisions (see schedstat.h)
+  uint decisions;
+  uint cycles;
+  uint max_cycles;
+  uint steals;                 // Processes taken from other CPUs
+};
+
 // Per-CPU state
 struct cpu {
   uchar apicid;                // Local APIC ID
@@ -8,6 +100,11 @@ struct cpu {
   int ncli;                    // Depth of pushcli nesting.
   int intena;                  // Were interrupts enabled before pushcli?
   struct proc *proc;           // The process running on this cpu or null
+  struct mlfq mlfq;            // Run queues of this cpu
+  volatile int idle;           // Halted with the periodic tick stopped
+  uint timerintr;              // Timer interrupts taken
+  uint idleintr;               // Interrupts taken while idle
+  uint halts;                  // Times this cpu went idle
 };
 
 extern struct cpu cpus[NCPU];
@@ -35,7 +132,10 @@ struct context {
 enum procstate { UNUSED, EMBRYO, SLEEPING, RUNNABLE, RUNNING, ZOMBIE };
 
 // Per-process state
+// lock protects state, chan, killed and pid.
+// parent is protected by ptable.lock.
 struct proc {
+  struct spinlock lock;
   uint sz;                     // Size of process memory (bytes)
   pde_t* pgdir;                // Page table
   char *kstack;                // Bottom of kernel stack for this process
@@ -45,6 +145,10 @@ struct proc {
   struct trapframe *tf;        // Trap frame for current syscall
   struct context *context;     // swtch() here to run process
   void *chan;                  // If non-zero, sleeping on chan
+  struct proc *sleepnext;      // Next sleeper in the same wait-channel bucket
+  uint deadline;               // Tick to wake up at, if on the timer wheel
+  int intimer;                 // On the timer wheel (tickslock)
+  struct proc *timernext;      // Next sleeper in the same timer wheel slot
   int killed;                  // If non-zero, have been killed
   struct file *ofile[NOFILE];  // Open files
   struct inode *cwd;           // Current directory
@@ -55,6 +159,18 @@ struct proc {
   int time_quantum;	           // Time of how much this process has been used
   int priority;		             // Priority in L2 queue
   int is_locked;		           // Variable indicating whether this process is locked or not
+  int cpu;                     // Index of the cpu whose MLFQ owns this process
+  enum schedclass class;       // Scheduling class
+  int tickets;                 // for stride: share of the cpu
+  uint stride;                 // STRIDE1 / tickets
+  uint pass;                   // Virtual time of its next run
+  int heapidx;                 // Index in the stride or EDF heap, -1 if not there
+  uint period;                 // for EDF: runtime ticks every period ticks
+  uint runtime;
+  uint util;                   // runtime / period, per mille
+  uint edf_deadline;           // End of the current period
+  uint budget;                 // Ticks left to run in the current period
+  uint readytsc;               // TSC when it last became RUNNABLE (for the trace)
 };
 
 // Process memory is laid out contiguously, low addresses first:
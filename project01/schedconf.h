@@ -0,0 +1,14 @@
+// MLFQ parameters, read and set at runtime with
+// getSchedConf() and setSchedConf().
+
+// How the last level (L2) orders its processes.
+#define L2_POLICY_PRIORITY 0   // by priority, lowest value first
+#define L2_POLICY_RR       1   // plain round robin, priority ignored
+
+struct schedconf {
+  int nlevel;                   // Number of levels, 2..MLFQ_MAXLEVEL
+  int quantum[MLFQ_MAXLEVEL];   // Time quantum of each level in ticks
+  int boost;                    // Ticks between priority boosts
+  int l2policy;                 // L2_POLICY_*
+  int lease;                    // Ticks a schedulerLock lease lasts at most
+};
@@ -0,0 +1,86 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "param.h"
+#include "schedconf.h"
+
+// Show or change the MLFQ parameters.
+//
+// schedctl                  print the parameters
+// schedctl levels N         use N levels (2..MLFQ_MAXLEVEL)
+// schedctl quantum L T      time quantum of level L is T ticks
+// schedctl boost T          boost every T ticks
+// schedctl policy priority  order L2 by priority
+// schedctl policy rr        plain round robin in L2
+// schedctl lease T          schedulerLock lasts at most T ticks
+// schedctl default          back to the built-in parameters
+
+void
+usage(void)
+{
+  printf(2, "usage: schedctl [levels N | quantum L T | boost T |"
+         " policy priority|rr | lease T | default]\n");
+  exit();
+}
+
+void
+show(struct schedconf *c)
+{
+  int i;
+
+  printf(1, "levels %d, boost %d, L2 policy %s, lease %d\n", c->nlevel,
+         c->boost, c->l2policy == L2_POLICY_RR ? "rr" : "priority", c->lease);
+  for(i = 0; i < c->nlevel; i++)
+    printf(1, "L%d quantum %d\n", i, c->quantum[i]);
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct schedconf c;
+  int i;
+
+  getSchedConf(&c);
+  if(argc < 2){
+    show(&c);
+    exit();
+  }
+
+  if(strcmp(argv[1], "levels") == 0 && argc == 3)
+    c.nlevel = atoi(argv[2]);
+  else if(strcmp(argv[1], "quantum") == 0 && argc == 4){
+    i = atoi(argv[2]);
+    if(i < 0 || i >= MLFQ_MAXLEVEL)
+      usage();
+    c.quantum[i] = atoi(argv[3]);
+  }
+  else if(strcmp(argv[1], "boost") == 0 && argc == 3)
+    c.boost = atoi(argv[2]);
+  else if(strcmp(argv[1], "lease") == 0 && argc == 3)
+    c.lease = atoi(argv[2]);
+  else if(strcmp(argv[1], "policy") == 0 && argc == 3){
+    if(strcmp(argv[2], "priority") == 0)
+      c.l2policy = L2_POLICY_PRIORITY;
+    else if(strcmp(argv[2], "rr") == 0)
+      c.l2policy = L2_POLICY_RR;
+    else
+      usage();
+  }
+  else if(strcmp(argv[1], "default") == 0 && argc == 2){
+    c.nlevel = 3;
+    for(i = 0; i < MLFQ_MAXLEVEL; i++)
+      c.quantum[i] = 2 * i + 4;
+    c.boost = 100;
+    c.l2policy = L2_POLICY_PRIORITY;
+    c.lease = 100;
+  }
+  else
+    usage();
+
+  if(setSchedConf(&c) < 0){
+    printf(2, "schedctl: invalid parameters\n");
+    exit();
+  }
+  show(&c);
+  exit();
+}
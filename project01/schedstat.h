@@ -0,0 +1,9 @@
+// Cost of MLFQ scheduling decisions, reported by getSchedStat().
+// Counters only grow (and wrap), so callers measure an interval
+// by taking the difference of two snapshots.
+struct schedstat {
+  uint decisions;   // Number of times scheduler() picked a process
+  uint cycles;      // Total TSC cycles spent picking them
+  uint max_cycles;  // Most expensive single decision
+  uint steals;      // Processes an idle cpu took from a busier one
+};
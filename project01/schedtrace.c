@@ -0,0 +1,112 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "timerstat.h"
+#include "schedtrace.h"
+
+// Scheduler trace dump.
+// usage: schedtrace [ticks]
+// Reads the scheduler trace for the given number of ticks
+// (default 300) while other programs run, and prints per level
+// how long processes waited to run (latency) and which share
+// of the cpu time each level got.
+
+#define NBUF 256
+#define NLEVEL 3
+#define NHIST 5
+
+// Upper bounds of the latency buckets, in us. A tick is 10000us.
+int bounds[NHIST - 1] = {100, 1000, 10000, 100000};
+
+char *reasons[TRACE_NREASON] = {
+  "expire", "yield", "sleep", "exit", "boost", "lock", "unlock", "lost"
+};
+
+struct levelstat {
+  int runs;
+  int hist[NHIST];
+  uint wait_us;
+  uint run_us;
+};
+
+struct levelstat levels[NLEVEL];
+int nreason[TRACE_NREASON];
+struct schedtrace buf[NBUF];
+
+void
+account(struct schedtrace *t, uint cycles_per_us)
+{
+  struct levelstat *l;
+  uint wait;
+  int i;
+
+  nreason[t->reason]++;
+  if(t->reason == TRACE_LOST){
+    // quantum holds the number of records lost.
+    nreason[t->reason] += t->quantum - 1;
+    return;
+  }
+  if(t->pid == 0 || t->reason == TRACE_BOOST ||
+     t->reason == TRACE_LOCK || t->reason == TRACE_UNLOCK)
+    return;
+
+  l = &levels[t->level];
+  wait = t->wait / cycles_per_us;
+  for(i = 0; i < NHIST - 1; i++)
+    if(wait < bounds[i])
+      break;
+  l->runs++;
+  l->hist[i]++;
+  l->wait_us += wait;
+  l->run_us += t->run / cycles_per_us;
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct timerstat st;
+  uint cycles_per_us, total;
+  int duration, i, j, n, start;
+  struct levelstat *l;
+
+  duration = 300;
+  if(argc > 1)
+    duration = atoi(argv[1]);
+
+  getTimerStat(&st);
+  cycles_per_us = st.tsc_per_tick / 10000;
+
+  // Drop what was recorded before we started.
+  while(getSchedTrace(buf, NBUF) == NBUF)
+    ;
+
+  start = uptime();
+  while(uptime() - start < duration){
+    sleep(5);
+    while((n = getSchedTrace(buf, NBUF)) > 0){
+      for(i = 0; i < n; i++)
+        account(&buf[i], cycles_per_us);
+      if(n < NBUF)
+        break;
+    }
+  }
+
+  total = 0;
+  for(i = 0; i < NLEVEL; i++)
+    total += levels[i].run_us;
+  if(total == 0)
+    total = 1;
+
+  printf(1, "level  runs  share  avg wait(us)  wait <100us <1ms <10ms <100ms more\n");
+  for(i = 0; i < NLEVEL; i++){
+    l = &levels[i];
+    printf(1, "L%d  %d  %d%%  %d ", i, l->runs, l->run_us / (total / 100 + 1),
+           l->runs ? l->wait_us / l->runs : 0);
+    for(j = 0; j < NHIST; j++)
+      printf(1, " %d", l->hist[j]);
+    printf(1, "\n");
+  }
+  for(i = 0; i < TRACE_NREASON; i++)
+    printf(1, "%s: %d\n", reasons[i], nreason[i]);
+  exit();
+}
@@ -0,0 +1,25 @@
+// One scheduler trace record, returned by getSchedTrace().
+// Each cpu records the processes it switches out, plus events.
+
+// Why the process stopped running, or which event this is.
+#define TRACE_EXPIRE   0   // Used up its quantum and was demoted
+#define TRACE_YIELD    1   // Tick ended, still has quantum left
+#define TRACE_SLEEP    2   // Went to sleep
+#define TRACE_EXIT     3   // Exited
+#define TRACE_BOOST    4   // Priority boost of the cpu's MLFQ (pid 0)
+#define TRACE_LOCK     5   // schedulerLock()
+#define TRACE_UNLOCK   6   // schedulerUnlock()
+#define TRACE_LOST     7   // Records overwritten before read (in quantum)
+#define TRACE_NREASON  8
+
+struct schedtrace {
+  uint tick;        // ticks when recorded
+  int pid;
+  uchar cpu;
+  uchar level;      // Level and L2 priority it ran at
+  uchar priority;
+  uchar reason;     // TRACE_*
+  uint quantum;     // Ticks of its quantum used before this run
+  uint wait;        // TSC cycles it was runnable before it ran
+  uint run;         // TSC cycles it ran
+};
@@ -7,5 +7,9 @@ struct spinlock {
   struct cpu *cpu;   // The cpu holding the lock.
   uint pcs[10];      // The call stack (an array of program counters)
                      // that locked the lock.
+
+  // For contention statistics:
+  uint nacquire;     // Number of times the lock was acquired.
+  uint nspin;        // Number of failed xchg while waiting for it.
 };
 
@@ -0,0 +1,103 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "param.h"
+
+// Stride scheduling share accuracy.
+// usage: stride_bench [ticks]
+// For 2 to 32 processes with 10, 20, 30, ... tickets, every process
+// counts units of work for the given number of ticks (default 2000,
+// so the five runs take 10k ticks). Stride processes keep their cpu,
+// so the share each got is compared with its share of the tickets
+// among the processes on the same cpu.
+
+#define NUM_RUNS 5
+#define UNIT 10000
+
+int nprocs[NUM_RUNS] = {2, 4, 8, 16, 32};
+
+struct result {
+  int tickets;
+  int cpu;
+  uint units;
+};
+
+void
+child(int fd, int tickets, int end)
+{
+  struct result r;
+  volatile int x;
+
+  r.tickets = tickets;
+  r.cpu = setTickets(getpid(), tickets);
+  r.units = 0;
+  while(uptime() < end){
+    for(x = 0; x < UNIT; x++)
+      ;
+    r.units++;
+  }
+  write(fd, &r, sizeof(r));
+  exit();
+}
+
+void
+run(int n, int ticks)
+{
+  struct result res[32];
+  uint units[NCPU], tickets[NCPU];
+  int fds[2], i, end, got, want, err, maxerr = 0, sumerr = 0;
+
+  if(pipe(fds) < 0){
+    printf(1, "pipe failed\n");
+    exit();
+  }
+  end = uptime() + ticks;
+  for(i = 0; i < n; i++){
+    if(fork() == 0){
+      close(fds[0]);
+      child(fds[1], (i + 1) * 10, end);
+    }
+  }
+  close(fds[1]);
+  for(i = 0; i < n && read(fds[0], &res[i], sizeof(res[i])) == sizeof(res[i]); i++)
+    ;
+  n = i;
+  close(fds[0]);
+  while(wait() != -1)
+    ;
+
+  memset(units, 0, sizeof(units));
+  memset(tickets, 0, sizeof(tickets));
+  for(i = 0; i < n; i++){
+    units[res[i].cpu] += res[i].units;
+    tickets[res[i].cpu] += res[i].tickets;
+  }
+  // Shares in per mille of the cpu's stride work.
+  for(i = 0; i < n; i++){
+    if(units[res[i].cpu] == 0)
+      continue;
+    got = res[i].units * 1000 / units[res[i].cpu];
+    want = res[i].tickets * 1000 / tickets[res[i].cpu];
+    err = got > want ? got - want : want - got;
+    sumerr += err;
+    if(err > maxerr)
+      maxerr = err;
+    if(n <= 4)
+      printf(1, "  cpu %d tickets %d: share %d, expected %d\n",
+             res[i].cpu, res[i].tickets, got, want);
+  }
+  printf(1, "%d processes: share error %d per mille on average, %d at most\n",
+         n, sumerr / n, maxerr);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int i, ticks = 2000;
+
+  if(argc > 1)
+    ticks = atoi(argv[1]);
+  for(i = 0; i < NUM_RUNS; i++)
+    run(nprocs[i], ticks);
+  exit();
+}
@@ -3,6 +3,7 @@
 #include "param.h"
 #include "memlayout.h"
 #include "mmu.h"
+#include "spinlock.h"
 #include "proc.h"
 #include "x86.h"
 #include "syscall.h"
@@ -109,6 +110,16 @@ extern int sys_getLevel(void);
 extern int sys_setPriority(void);
 extern int sys_schedulerLock(void);
 extern int sys_schedulerUnlock(void);
+extern int sys_getSchedStat(void);
+extern int sys_getLockStat(void);
+extern int sys_getTimerStat(void);
+extern int sys_getSchedTrace(void);
+extern int sys_getSchedConf(void);
+extern int sys_setSchedConf(void);
+extern int sys_getLeaseStat(void);
+extern int sys_setTickets(void);
+extern int sys_setDeadline(void);
+extern int sys_getEDFStat(void);
 
 static int (*syscalls[])(void) = {
 [SYS_fork]    sys_fork,
@@ -138,6 +149,16 @@ static int (*syscalls[])(void) = {
 [SYS_setPriority]   sys_setPriority,
 [SYS_schedulerLock]   sys_schedulerLock,
 [SYS_schedulerUnlock]   sys_schedulerUnlock,
+[SYS_getSchedStat]   sys_getSchedStat,
+[SYS_getLockStat]   sys_getLockStat,
+[SYS_getTimerStat]  sys_getTimerStat,
+[SYS_getSchedTrace] sys_getSchedTrace,
+[SYS_getSchedConf]  sys_getSchedConf,
+[SYS_setSchedConf]  sys_setSchedConf,
+[SYS_getLeaseStat]  sys_getLeaseStat,
+[SYS_setTickets]    sys_setTickets,
+[SYS_setDeadline]   sys_setDeadline,
+[SYS_getEDFStat]    sys_getEDFStat,
 };
 
 void
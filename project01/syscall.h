@@ -25,4 +25,14 @@
 #define SYS_getLevel 24
 #define SYS_setPriority 25
 #define SYS_schedulerLock 26
-#define SYS_schedulerUnlock 27
\ No newline at end of file
+#define SYS_schedulerUnlock 27
+#define SYS_getSchedStat 28
+#define SYS_getLockStat 29
+#define SYS_getTimerStat 30
+#define SYS_getSchedTrace 31
+#define SYS_getSchedConf 32
+#define SYS_setSchedConf 33
+#define SYS_getLeaseStat 34
+#define SYS_setTickets 35
+#define SYS_setDeadline 36
+#define SYS_getEDFStat 37
\ No newline at end of file
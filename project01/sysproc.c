@@ -5,7 +5,15 @@
 #include "param.h"
 #include "memlayout.h"
 #include "mmu.h"
+#include "spinlock.h"
 #include "proc.h"
+#include "schedstat.h"
+#include "lockstat.h"
+#include "timerstat.h"
+#include "schedtrace.h"
+#include "schedconf.h"
+#include "leasestat.h"
+#include "edfstat.h"
 
 int
 sys_fork(void)
@@ -60,21 +68,10 @@ int
 sys_sleep(void)
 {
   int n;
-  uint ticks0;
 
   if(argint(0, &n) < 0)
     return -1;
-  acquire(&tickslock);
-  ticks0 = ticks;
-  while(ticks - ticks0 < n){
-    if(myproc()->killed){
-      release(&tickslock);
-      return -1;
-    }
-    sleep(&ticks, &tickslock);
-  }
-  release(&tickslock);
-  return 0;
+  return timersleep(n);
 }
 
 // return how many clock tick interrupts have occurred
@@ -82,12 +79,7 @@ sys_sleep(void)
 int
 sys_uptime(void)
 {
-  uint xticks;
-
-  acquire(&tickslock);
-  xticks = ticks;
-  release(&tickslock);
-  return xticks;
+  return timerticks();
 }
 
 // yield
@@ -139,4 +131,130 @@ sys_schedulerUnlock(void)
   
   schedulerUnlock(password); // 받은 parameter을 기반으로 함수를 호출
   return 0;
-}
\ No newline at end of file
+}
+
+// getSchedStat
+int
+sys_getSchedStat(void)
+{
+  struct schedstat *st;
+  if(argptr(0, (void*)&st, sizeof(*st)) < 0) // 주소가 올바르지 않은 경우 -1을 반환.
+    return -1;
+
+  getSchedStat(st); // 받은 parameter을 기반으로 함수를 호출
+  return 0;
+}
+
+// getLockStat
+int
+sys_getLockStat(void)
+{
+  struct lockstat *st;
+  if(argptr(0, (void*)&st, sizeof(*st)) < 0) // 주소가 올바르지 않은 경우 -1을 반환.
+    return -1;
+
+  getLockStat(st); // 받은 parameter을 기반으로 함수를 호출
+  return 0;
+}
+
+// getTimerStat
+int
+sys_getTimerStat(void)
+{
+  struct timerstat *st;
+  if(argptr(0, (void*)&st, sizeof(*st)) < 0) // 주소가 올바르지 않은 경우 -1을 반환.
+    return -1;
+
+  getTimerStat(st); // 받은 parameter을 기반으로 함수를 호출
+  return 0;
+}
+
+// getSchedTrace
+// buf에 최대 n개의 trace record를 읽어오고 읽은 개수를 반환한다.
+int
+sys_getSchedTrace(void)
+{
+  struct schedtrace *buf;
+  int n;
+
+  // overrun record를 위해 최소 2개의 공간이 필요하다.
+  if(argint(1, &n) < 0 || n < 2 || n > 0x10000)
+    return -1;
+  if(argptr(0, (void*)&buf, n * sizeof(*buf)) < 0) // 주소가 올바르지 않은 경우 -1을 반환.
+    return -1;
+
+  return getSchedTrace(buf, n);
+}
+
+// getSchedConf
+int
+sys_getSchedConf(void)
+{
+  struct schedconf *c;
+  if(argptr(0, (void*)&c, sizeof(*c)) < 0) // 주소가 올바르지 않은 경우 -1을 반환.
+    return -1;
+
+  getSchedConf(c); // 받은 parameter을 기반으로 함수를 호출
+  return 0;
+}
+
+// setSchedConf
+int
+sys_setSchedConf(void)
+{
+  struct schedconf *c;
+  if(argptr(0, (void*)&c, sizeof(*c)) < 0) // 주소가 올바르지 않은 경우 -1을 반환.
+    return -1;
+
+  return setSchedConf(c); // 받은 parameter을 기반으로 함수를 호출
+}
+
+// getLeaseStat
+int
+sys_getLeaseStat(void)
+{
+  struct leasestat *st;
+  if(argptr(0, (void*)&st, sizeof(*st)) < 0) // 주소가 올바르지 않은 경우 -1을 반환.
+    return -1;
+
+  getLeaseStat(st); // 받은 parameter을 기반으로 함수를 호출
+  return 0;
+}
+
+// setTickets
+int
+sys_setTickets(void)
+{
+  int pid, tickets;
+
+  // 인자가 올바르지 않은 경우 -1을 반환.
+  if(argint(0, &pid) < 0 || argint(1, &tickets) < 0)
+    return -1;
+
+  return setTickets(pid, tickets); // 받은 parameter을 기반으로 함수를 호출
+}
+
+// setDeadline
+int
+sys_setDeadline(void)
+{
+  int period, runtime;
+
+  // 인자가 올바르지 않은 경우 -1을 반환.
+  if(argint(0, &period) < 0 || argint(1, &runtime) < 0)
+    return -1;
+
+  return setDeadline(period, runtime); // 받은 parameter을 기반으로 함수를 호출
+}
+
+// getEDFStat
+int
+sys_getEDFStat(void)
+{
+  struct edfstat *st;
+  if(argptr(0, (void*)&st, sizeof(*st)) < 0) // 주소가 올바르지 않은 경우 -1을 반환.
+    return -1;
+
+  getEDFStat(st); // 받은 parameter을 기반으로 함수를 호출
+  return 0;
+}
@@ -0,0 +1,78 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "timerstat.h"
+
+// Tickless idle benchmark.
+// First the machine is left idle and the interrupts taken by
+// halted cpus are counted; then sleep(n) is timed with the TSC
+// to see how late the wakeups are.
+
+#define IDLE_TICKS 500
+#define NUM_SLEEP 20
+
+#define NUM_RUNS 4
+
+int lengths[NUM_RUNS] = {1, 2, 5, 10};
+
+static inline unsigned long long
+rdtsc(void)
+{
+  unsigned long long t;
+  asm volatile("rdtsc" : "=A" (t));
+  return t;
+}
+
+void
+idle(void)
+{
+  struct timerstat before, after;
+  int t, intr, idleintr;
+
+  getTimerStat(&before);
+  sleep(IDLE_TICKS);
+  getTimerStat(&after);
+
+  t = after.ticks - before.ticks;
+  intr = after.timerintr - before.timerintr;
+  idleintr = after.idleintr - before.idleintr;
+  // 100 ticks per second.
+  printf(1, "idle %d ticks: %d timer interrupts/s, %d idle interrupts/s, %d halts\n",
+         t, intr * 100 / t, idleintr * 100 / t, after.halts - before.halts);
+}
+
+void
+latency(int n, uint cycles_per_us)
+{
+  unsigned long long start;
+  int i, late, total = 0, max = 0;
+
+  for(i = 0; i < NUM_SLEEP; i++){
+    // Start right after a tick so sleep(n) should take n ticks.
+    sleep(1);
+    start = rdtsc();
+    sleep(n);
+    late = (int)((uint)(rdtsc() - start) / cycles_per_us) - n * 10000;
+    total += late;
+    if(late > max)
+      max = late;
+  }
+  printf(1, "sleep(%d): late by %d us on average, %d us at most\n",
+         n, total / NUM_SLEEP, max);
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct timerstat st;
+  int i;
+
+  getTimerStat(&st);
+  printf(1, "%d TSC cycles per tick\n", st.tsc_per_tick);
+
+  idle();
+  // A tick is 10ms.
+  for(i = 0; i < NUM_RUNS; i++)
+    latency(lengths[i], st.tsc_per_tick / 10000);
+  exit();
+}
@@ -0,0 +1,180 @@
+// Timekeeping and the timer wheel of sleeping processes.
+//
+// ticks is kept by the TSC, calibrated against the LAPIC timer
+// at boot, so any cpu taking an interrupt can bring it up to date
+// and an idle cpu can stop its periodic tick (see mlfq_idle in proc.c).
+//
+// A process in sleep(n) is put on the wheel slot of its deadline
+// and woken once, by the tick that reaches it, instead of
+// rechecking on every tick.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "x86.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "timerstat.h"
+
+#define NTIMERWHEEL 64
+
+// Protected by tickslock.
+static struct {
+  unsigned long long start;          // TSC at the start of the current tick
+  int nsleep;                        // Processes on the wheel
+  struct proc *wheel[NTIMERWHEEL];   // Sleepers by deadline % NTIMERWHEEL
+} tm;
+
+// Wake the sleepers whose deadline is tick t.
+// Caller holds tickslock.
+static void
+timerexpire(uint t)
+{
+  struct proc **pp, *p;
+
+  pp = &tm.wheel[t % NTIMERWHEEL];
+  while((p = *pp) != 0){
+    if((int)(t - p->deadline) >= 0){
+      *pp = p->timernext;
+      p->intimer = 0;
+      tm.nsleep--;
+      wakeup(&p->deadline);
+    } else
+      pp = &p->timernext;
+  }
+}
+
+// Advance ticks to the current TSC, one tick at a time
+// so that no wheel slot is skipped after a long idle period.
+// Caller holds tickslock.
+static void
+timeradvance(void)
+{
+  unsigned long long now = rdtsc();
+
+  if(tm.start == 0){
+    tm.start = now;
+    return;
+  }
+  // The TSCs of different cpus may be slightly apart;
+  // never go backwards.
+  while((long long)(now - tm.start) >= tsc_per_tick){
+    tm.start += tsc_per_tick;
+    ticks++;
+    if(tm.nsleep > 0)
+      timerexpire(ticks);
+  }
+}
+
+// Called on every timer interrupt, by every cpu.
+void
+timertick(void)
+{
+  acquire(&tickslock);
+  timeradvance();
+  release(&tickslock);
+}
+
+// Current tick.
+uint
+timerticks(void)
+{
+  uint xticks;
+
+  acquire(&tickslock);
+  timeradvance();
+  xticks = ticks;
+  release(&tickslock);
+  return xticks;
+}
+
+// Sleep for n ticks.
+// Returns -1 if killed before the deadline.
+int
+timersleep(int n)
+{
+  struct proc *p = myproc();
+  struct proc **pp;
+
+  acquire(&tickslock);
+  timeradvance();
+  if(n <= 0){
+    release(&tickslock);
+    return 0;
+  }
+  p->deadline = ticks + n;
+  p->timernext = tm.wheel[p->deadline % NTIMERWHEEL];
+  tm.wheel[p->deadline % NTIMERWHEEL] = p;
+  p->intimer = 1;
+  tm.nsleep++;
+
+  while(p->intimer){
+    if(p->killed){
+      for(pp = &tm.wheel[p->deadline % NTIMERWHEEL]; *pp != p; pp = &(*pp)->timernext)
+        ;
+      *pp = p->timernext;
+      p->intimer = 0;
+      tm.nsleep--;
+      release(&tickslock);
+      return -1;
+    }
+    sleep(&p->deadline, &tickslock);
+  }
+  release(&tickslock);
+  return 0;
+}
+
+// TSC cycles from now until the earliest sleeper deadline,
+// capped to 32 bits, or 0 if nobody is sleeping.
+uint
+timernext(void)
+{
+  struct proc *p;
+  unsigned long long when;
+  long long left;
+  uint d, min;
+  int i;
+
+  acquire(&tickslock);
+  timeradvance();
+  if(tm.nsleep == 0){
+    release(&tickslock);
+    return 0;
+  }
+  min = 0xFFFFFFFF;
+  for(i = 0; i < NTIMERWHEEL; i++){
+    for(p = tm.wheel[i]; p; p = p->timernext){
+      d = p->deadline - ticks;
+      if(d < min)
+        min = d;
+    }
+  }
+  when = tm.start + (unsigned long long)min * tsc_per_tick;
+  release(&tickslock);
+
+  left = when - rdtsc();
+  if(left <= 0)
+    return 1;
+  if(left > 0xFFFFFFFF)
+    return 0xFFFFFFFF;
+  return left;
+}
+
+// Snapshot of the timer interrupt counters, summed over all cpus.
+// Each cpu only updates its own counters, so they are read without locks.
+void
+getTimerStat(struct timerstat *st)
+{
+  struct cpu *c;
+
+  memset(st, 0, sizeof(*st));
+  st->ticks = timerticks();
+  st->tsc_per_tick = tsc_per_tick;
+  for(c = cpus; c < &cpus[ncpu]; c++){
+    st->timerintr += c->timerintr;
+    st->idleintr += c->idleintr;
+    st->halts += c->halts;
+  }
+}
@@ -0,0 +1,11 @@
+// Timer state and interrupt counters, reported by getTimerStat().
+// ticks and tsc_per_tick are current values. The other fields are
+// counts since boot summed over all cpus; they wrap, so subtract
+// two snapshots to measure an interval.
+struct timerstat {
+  uint ticks;          // Current tick
+  uint tsc_per_tick;   // TSC cycles per tick
+  uint timerintr;      // Timer interrupts taken
+  uint idleintr;       // Interrupts taken by idle cpus
+  uint halts;          // Times a cpu went idle
+};
@@ -0,0 +1,108 @@
+// Scheduler trace.
+//
+// Every cpu appends to its own ring, with interrupts off, so
+// writing needs no lock: the record is filled in first and then
+// head is advanced. getSchedTrace() drains the rings; a record
+// overwritten by its cpu while being copied is dropped.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "x86.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "schedtrace.h"
+
+#define NTRACE 512
+
+static struct {
+  struct schedtrace ent[NTRACE];
+  uint head;    // Records written, by the owning cpu only
+  uint tail;    // Records read, under tracelock
+} ring[NCPU];
+
+// Serializes readers.
+static struct spinlock tracelock;
+
+void
+traceinit(void)
+{
+  initlock(&tracelock, "trace");
+}
+
+// Append t to this cpu's ring.
+// Caller must have interrupts off.
+void
+tracesched(struct schedtrace *t)
+{
+  int id = cpuid();
+
+  t->cpu = id;
+  t->tick = ticks;
+  ring[id].ent[ring[id].head % NTRACE] = *t;
+  __sync_synchronize();
+  ring[id].head++;
+}
+
+// Append an event of the process running on this cpu,
+// or of the cpu itself if p is 0.
+void
+traceevent(struct proc *p, int reason)
+{
+  struct schedtrace t;
+
+  memset(&t, 0, sizeof(t));
+  if(p){
+    t.pid = p->pid;
+    t.level = p->level;
+    t.priority = p->priority;
+    t.quantum = p->time_quantum;
+  }
+  t.reason = reason;
+  pushcli();
+  tracesched(&t);
+  popcli();
+}
+
+// Move up to n unread records, from all cpus, to buf.
+// Records of one cpu are in order, but cpus are not merged.
+// Returns the number of records.
+int
+getSchedTrace(struct schedtrace *buf, int n)
+{
+  uint head, lost;
+  int i, k = 0;
+
+  acquire(&tracelock);
+  for(i = 0; i < ncpu && k < n; i++){
+    head = ring[i].head;
+    __sync_synchronize();
+    lost = 0;
+    if(head - ring[i].tail > NTRACE){
+      lost = head - ring[i].tail - NTRACE;
+      ring[i].tail = head - NTRACE;
+    }
+    while(ring[i].tail != head && k < n - 1){
+      buf[k] = ring[i].ent[ring[i].tail % NTRACE];
+      __sync_synchronize();
+      // The writer may have come around while we copied.
+      if(ring[i].head - ring[i].tail > NTRACE)
+        lost++;
+      else
+        k++;
+      ring[i].tail++;
+    }
+    if(lost){
+      memset(&buf[k], 0, sizeof(buf[k]));
+      buf[k].cpu = i;
+      buf[k].tick = ticks;
+      buf[k].reason = TRACE_LOST;
+      buf[k].quantum = lost;
+      k++;
+    }
+  }
+  release(&tracelock);
+  return k;
+}
@@ -3,10 +3,10 @@
 #include "param.h"
 #include "memlayout.h"
 #include "mmu.h"
+#include "spinlock.h"
 #include "proc.h"
 #include "x86.h"
 #include "traps.h"
-#include "spinlock.h"
 
 // Interrupt descriptor table (shared by all CPUs).
 struct gatedesc idt[256];
@@ -71,14 +71,18 @@ trap(struct trapframe *tf)
     return;
   }
 
+  if(mycpu()->idle)
+    mycpu()->idleintr++;
+
   switch(tf->trapno){
   case T_IRQ0 + IRQ_TIMER:
-    if(cpuid() == 0){
-      acquire(&tickslock);
-      ticks++;
-      wakeup(&ticks);
-      release(&tickslock);
-    }
+    // Every cpu keeps time, since idle cpus stop their tick.
+    mycpu()->timerintr++;
+    timertick();
+    lapiceoi();
+    break;
+  case T_IRQ0 + IRQ_WAKEUP:
+    // Another cpu queued work for this idle cpu.
     lapiceoi();
     break;
   case T_IRQ0 + IRQ_IDE:
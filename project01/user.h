@@ -1,5 +1,12 @@
 struct stat;
 struct rtcdate;
+struct schedstat;
+struct lockstat;
+struct timerstat;
+struct schedtrace;
+struct schedconf;
+struct leasestat;
+struct edfstat;
 
 // system calls
 int fork(void);
@@ -29,6 +36,16 @@ int getLevel(void);
 void setPriority(int, int);
 void schedulerLock(int);
 void schedulerUnlock(int);
+int getSchedStat(struct schedstat*);
+int getLockStat(struct lockstat*);
+int getTimerStat(struct timerstat*);
+int getSchedTrace(struct schedtrace*, int);
+int getSchedConf(struct schedconf*);
+int setSchedConf(struct schedconf*);
+int getLeaseStat(struct leasestat*);
+int setTickets(int, int);
+int setDeadline(int, int);
+int getEDFStat(struct edfstat*);
 
 // ulib.c
 int stat(const char*, struct stat*);
@@ -138,6 +138,15 @@ rcr2(void)
   return val;
 }
 
+// Read the time-stamp counter.
+static inline unsigned long long
+rdtsc(void)
+{
+  unsigned long long val;
+  asm volatile("rdtsc" : "=A" (val));
+  return val;
+}
+
 static inline void
 lcr3(uint val)
 {
@@ -0,0 +1,113 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "kmemstat.h"
+
+// Copy-on-write fork benchmark.
+// For images from 64KiB to 16MiB, compares eager and copy-on-write
+// fork: the time of a fork followed by exec in the child (as the
+// shell does), and the pages a forked child takes before it runs.
+// Uses setcowfork() to switch, and restores the setting at the end.
+
+#define NUM_SIZES 5
+#define NUM_FORK 20
+
+int sizes[NUM_SIZES] = {64, 256, 1024, 4096, 16384};   // KiB
+
+// Free pages, wherever they are cached.
+uint
+freepages(void)
+{
+  struct kmemstat st;
+
+  getkmemstat(&st);
+  return st.nfree + st.ncached;
+}
+
+// Average time of fork + exec + exit, in us.
+int
+forkexec(void)
+{
+  char *argv[] = {"cow_bench", "exit", 0};
+  int i, start;
+
+  start = uptime();
+  for(i = 0; i < NUM_FORK; i++){
+    if(fork() == 0){
+      exec(argv[0], argv);
+      printf(1, "exec failed\n");
+      exit();
+    }
+    wait();
+  }
+  // A tick is 10ms.
+  return (uptime() - start) * 10000 / NUM_FORK;
+}
+
+// Pages taken by fork while the child waits on a pipe.
+int
+forkpages(void)
+{
+  int fds[2];
+  uint before, after;
+  char c;
+
+  if(pipe(fds) < 0){
+    printf(1, "pipe failed\n");
+    exit();
+  }
+  before = freepages();
+  if(fork() == 0){
+    close(fds[1]);
+    read(fds[0], &c, 1);
+    exit();
+  }
+  after = freepages();
+  close(fds[0]);
+  write(fds[1], "x", 1);
+  close(fds[1]);
+  wait();
+  return before - after;
+}
+
+void
+run(int kb)
+{
+  char *p;
+  int i, eager_us, eager_pages, cow_us, cow_pages;
+
+  p = sbrk(kb * 1024);
+  if(p == (char*)-1){
+    printf(1, "%dKiB: sbrk failed\n", kb);
+    return;
+  }
+  for(i = 0; i < kb * 1024; i += 4096)
+    p[i] = i;
+
+  setcowfork(0);
+  eager_us = forkexec();
+  eager_pages = forkpages();
+  setcowfork(1);
+  cow_us = forkexec();
+  cow_pages = forkpages();
+
+  printf(1, "%dKiB: eager %d us %d pages, cow %d us %d pages\n",
+         kb, eager_us, eager_pages, cow_us, cow_pages);
+  sbrk(-kb * 1024);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int i, old;
+
+  if(argc > 1 && strcmp(argv[1], "exit") == 0)
+    exit();
+
+  old = setcowfork(1);
+  printf(1, "fork+exec, %d runs each\n", NUM_FORK);
+  for(i = 0; i < NUM_SIZES; i++)
+    run(sizes[i]);
+  setcowfork(old);
+  exit();
+}
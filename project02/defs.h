@@ -2,14 +2,19 @@ struct buf;
 struct context;
 struct file;
 struct inode;
+struct kmemstat;
 struct pipe;
 struct proc;
+struct procstat;
 struct rtcdate;
 struct spinlock;
 struct sleeplock;
+struct slabcache;
 struct stat;
 struct superblock;
 struct thread;
+struct thread_attr;
+struct threadstat;
 
 // bio.c
 void            binit(void);
@@ -72,6 +77,11 @@ char*           kalloc(void);
 void            kfree(char*);
 void            kinit1(void*, void*);
 void            kinit2(void*, void*);
+void            getkmemstat(struct kmemstat*);
+void            kref(char*);
+int             krefs(char*);
+int             kreftry(char*, int);
+uint            kfreepages(void);
 
 // kbd.c
 void            kbdintr(void);
@@ -82,6 +92,7 @@ int             lapicid(void);
 extern volatile uint*    lapic;
 void            lapiceoi(void);
 void            lapicinit(void);
+void            lapicipi(int, int);
 void            lapicstartap(uchar, uint);
 void            microdelay(int);
 
@@ -99,7 +110,32 @@ void            mpinit(void);
 void            picenable(int);
 void            picinit(void);
 
+// slab.c
+void            slabinit(struct slabcache*, char*, uint, void (*)(void*));
+void*           slaballoc(struct slabcache*);
+void            slabfree(struct slabcache*, void*);
+
+// pcache.c
+void            pcinit(void);
+char*           pcget(struct inode*, uint);
+char*           pcadd(struct inode*, uint, char*);
+int             pccached(char*);
+void            pcfree(char*);
+void            pcinval(struct inode*);
+void            pcstat(uint*, uint*, uint*);
+
+// swap.c
+void            swapinit(int);
+int             swapout(void);
+void            swaplock(void);
+void            swapunlock(void);
+void            swapread(uint, char*);
+void            swapdup(uint);
+void            swapfree(uint);
+void            swapstat(uint*, uint*, uint*);
+
 // pipe.c
+void            pipeinit(void);
 int             pipealloc(struct file**, struct file**);
 void            pipeclose(struct pipe*, int);
 int             piperead(struct pipe*, char*, int);
@@ -125,10 +161,18 @@ int             wait(void);
 void            wakeup(void*);
 void            yield(void);
 int             setmemorylimit(int, int);
+int             setcowfork(int);
+char*           swapvictim(uint);
 void            list(void);
+int             getprocstat(struct procstat*, int);
+int             getthreadstat(int, struct threadstat*, int);
+int             futexwait(uint, uint);
+int             futexwake(uint, int);
 struct thread*  mainthread(struct proc *);
-struct thread*  mythread(struct proc *);
-int thread_create(thread_t*thread, void *(*start_routine)(void *), void *arg);
+struct thread*  mythread(void);
+void            clearthreads(struct proc *);
+pde_t*          commituvm(struct proc*, pde_t*, uint);
+int thread_create(thread_t*thread, void *(*start_routine)(void *), void *arg, struct thread_attr *attr);
 void thread_exit(void *retval);
 int thread_join(thread_t thread, void **retval);
 
@@ -192,9 +236,21 @@ void            freevm(pde_t*);
 void            inituvm(pde_t*, char*, uint);
 int             loaduvm(pde_t*, char*, struct inode*, uint, uint);
 pde_t*          copyuvm(pde_t*, uint);
+pde_t*          cowuvm(pde_t*, uint);
+int             cowfault(pde_t*, uint);
+int             pagefault(uint, uint);
+int             uvmtouch(uint, uint);
+int             uvmresident(pde_t*, uint, uint);
+uint*           uvmfutex(pde_t*, uint);
+void            uvmstat(pde_t*, uint, struct procstat*);
+char*           uvmevict(struct proc*, uint*, uint);
+int             swapin(pde_t*, uint);
 void            switchuvm(struct proc*);
 void            switchkvm(void);
+void            tlbpoll(void);
+void            tlbshootdown(pde_t*);
 int             copyout(pde_t*, uint, void*, uint);
+int             uvmclear(pde_t*, uint, uint);
 void            clearpteu(pde_t *pgdir, char *uva);
 
 // number of elements in fixed-size array
@@ -17,8 +17,10 @@ exec2(char *path, char **argv, int stacksize)
   struct inode *ip;
   struct proghdr ph;
   pde_t *pgdir, *oldpgdir;
+  struct inode *exe, *oldexe;
+  struct execseg seg[NEXECSEG];
+  int nseg;
   struct proc *curproc = myproc();
-  struct thread *t;
 
   if (stacksize <= 0 || stacksize > 100){
     cprintf("exec2: illegal stack size\n");
@@ -34,6 +36,7 @@ exec2(char *path, char **argv, int stacksize)
   }
   ilock(ip);
   pgdir = 0;
+  exe = 0;
 
   // Check ELF header
   if(readi(ip, (char*)&elf, 0, sizeof(elf)) != sizeof(elf))
@@ -44,8 +47,10 @@ exec2(char *path, char **argv, int stacksize)
   if((pgdir = setupkvm()) == 0)
     goto bad;
 
-  // Load program into memory.
+  // Only note where the segments are: pagefault() reads each
+  // page from ip the first time the program touches it.
   sz = 0;
+  nseg = 0;
   for(i=0, off=elf.phoff; i<elf.phnum; i++, off+=sizeof(ph)){
     if(readi(ip, (char*)&ph, off, sizeof(ph)) != sizeof(ph))
       goto bad;
@@ -55,15 +60,23 @@ exec2(char *path, char **argv, int stacksize)
       goto bad;
     if(ph.vaddr + ph.memsz < ph.vaddr)
       goto bad;
-    if((sz = allocuvm(pgdir, sz, ph.vaddr + ph.memsz)) == 0)
+    if(ph.vaddr + ph.memsz >= KERNBASE)
       goto bad;
     if(ph.vaddr % PGSIZE != 0)
       goto bad;
-    if(loaduvm(pgdir, (char*)ph.vaddr, ip, ph.off, ph.filesz) < 0)
+    if(nseg == NEXECSEG)
       goto bad;
+    seg[nseg].vaddr = ph.vaddr;
+    seg[nseg].filesz = ph.filesz;
+    seg[nseg].off = ph.off;
+    nseg++;
+    if(ph.vaddr + ph.memsz > sz)
+      sz = ph.vaddr + ph.memsz;
   }
-  iunlockput(ip);
+  // Keep the reference to ip for the page faults.
+  iunlock(ip);
   end_op();
+  exe = ip;
   ip = 0;
 
   // Allocate two pages at the next page boundary.
@@ -102,35 +115,36 @@ exec2(char *path, char **argv, int stacksize)
   safestrcpy(curproc->name, last, sizeof(curproc->name));
 
   // Commit to the user image.
-  oldpgdir = curproc->pgdir;
-  curproc->pgdir = pgdir;
-  curproc->sz = sz;
-
-  curproc->mainidx = curproc->rectidx;
-  curproc->_ustack[curproc->rectidx] = sz;
-
-  for(i = 0; i < NPROC; i++){
-    if (i == curproc->mainidx) continue;
-    t = &curproc->ttable[i];
-    if (t->state != UNUSED) 
-      kfree(t->kstack);
-    t->kstack = 0;
-    t->tid = 0;
-    t->retval = 0;
-    t->state = UNUSED;
-    curproc->_ustack[i] = 0;
-  }
+  oldpgdir = commituvm(curproc, pgdir, sz);
+  oldexe = curproc->exe;
+  curproc->exe = exe;
+  memmove(curproc->seg, seg, sizeof(seg));
+  curproc->nseg = nseg;
+
+  curproc->main = mythread();
+  curproc->main->ustack = sz;
+  curproc->main->stackpages = 0;
+  curproc->main->tls = 0;
+  curproc->main->tlspages = 0;
+
+  // main thread를 제외한 모든 thread를 정리한다.
+  clearthreads(curproc);
 
 
   curproc->memlim = 0;
   curproc->ssize = stacksize + 1;
-  curproc->nextidx = curproc->rectidx;
   mainthread(curproc)->tf->eip = elf.entry;  // main
   mainthread(curproc)->tf->esp = sp;
+  mainthread(curproc)->tf->gs = 0;
   
 
   switchuvm(curproc);
   freevm(oldpgdir);
+  if(oldexe){
+    begin_op();
+    iput(oldexe);
+    end_op();
+  }
   return 0;
 
  bad:
@@ -140,5 +154,10 @@ exec2(char *path, char **argv, int stacksize)
     iunlockput(ip);
     end_op();
   }
+  if(exe){
+    begin_op();
+    iput(exe);
+    end_op();
+  }
   return -1;
 }
\ No newline at end of file
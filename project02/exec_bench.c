@@ -0,0 +1,50 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+// Exec startup latency.
+// Runs each program NUM_EXEC times with its standard file
+// descriptors closed, so that it stops right away (mkdir and rm
+// create and remove a directory x), and prints the
+// average time of fork + exec + exit next to the binary size.
+// exec only reads the pages a program touches, so the time should
+// no longer grow with the size of the binary.
+
+#define NUM_EXEC 20
+#define NUM_PROGS 9
+
+char *progs[NUM_PROGS] = {
+  "echo", "cat", "grep", "wc", "ls", "kill", "mkdir", "rm", "ln"
+};
+
+int
+main(int argc, char *argv[])
+{
+  char *args[] = {0, "x", 0};
+  struct stat st;
+  int i, j, start;
+
+  printf(1, "program  size  us per fork+exec+exit\n");
+  for(i = 0; i < NUM_PROGS; i++){
+    if(stat(progs[i], &st) < 0){
+      printf(1, "%s: not found\n", progs[i]);
+      continue;
+    }
+    args[0] = progs[i];
+    start = uptime();
+    for(j = 0; j < NUM_EXEC; j++){
+      if(fork() == 0){
+        close(0);
+        close(1);
+        close(2);
+        exec(args[0], args);
+        exit();
+      }
+      wait();
+    }
+    // A tick is 10ms.
+    printf(1, "%s  %d  %d\n", progs[i], st.size,
+           (uptime() - start) * 10000 / NUM_EXEC);
+  }
+  exit();
+}
@@ -14,8 +14,10 @@ struct inode {
   uint dev;           // Device number
   uint inum;          // Inode number
   int ref;            // Reference count
+  struct inode *next; // Next in its icache bucket
   struct sleeplock lock; // protects everything below here
   int valid;          // inode has been read from disk?
+  int pcached;        // may have pages in the program page cache
 
   short type;         // copy of disk inode
   short major;
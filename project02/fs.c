@@ -20,6 +20,7 @@
 #include "fs.h"
 #include "buf.h"
 #include "file.h"
+#include "slab.h"
 
 #define min(a, b) ((a) < (b) ? (a) : (b))
 static void itrunc(struct inode*);
@@ -155,7 +156,9 @@ bfree(int dev, uint b)
 // multi-step atomic operations.
 //
 // The icache.lock spin-lock protects the allocation of icache
-// entries. Since ip->ref indicates whether an entry is free,
+// entries. Entries come from a slab cache and are hashed on
+// inum while referenced; the last iput() frees the entry.
+// Since ip->ref indicates whether an entry is in use,
 // and ip->dev and ip->inum indicate which i-node an entry
 // holds, one must hold icache.lock while using any of those fields.
 //
@@ -163,20 +166,25 @@ bfree(int dev, uint b)
 // dev, and inum.  One must hold ip->lock in order to
 // read or write that inode's ip->valid, ip->size, ip->type, &c.
 
+#define NINODEHASH 64
+
 struct {
   struct spinlock lock;
-  struct inode inode[NINODE];
+  struct slabcache cache;
+  struct inode *hash[NINODEHASH];
 } icache;
 
+static void
+inodector(void *v)
+{
+  initsleeplock(&((struct inode*)v)->lock, "inode");
+}
+
 void
 iinit(int dev)
 {
-  int i = 0;
-  
   initlock(&icache.lock, "icache");
-  for(i = 0; i < NINODE; i++) {
-    initsleeplock(&icache.inode[i].lock, "inode");
-  }
+  slabinit(&icache.cache, "inode", sizeof(struct inode), inodector);
 
   readsb(dev, &sb);
   cprintf("sb: size %d nblocks %d ninodes %d nlog %d logstart %d\
@@ -241,31 +249,31 @@ iupdate(struct inode *ip)
 static struct inode*
 iget(uint dev, uint inum)
 {
-  struct inode *ip, *empty;
+  struct inode *ip, **bucket;
 
   acquire(&icache.lock);
 
   // Is the inode already cached?
-  empty = 0;
-  for(ip = &icache.inode[0]; ip < &icache.inode[NINODE]; ip++){
-    if(ip->ref > 0 && ip->dev == dev && ip->inum == inum){
+  bucket = &icache.hash[inum % NINODEHASH];
+  for(ip = *bucket; ip; ip = ip->next){
+    if(ip->dev == dev && ip->inum == inum){
       ip->ref++;
       release(&icache.lock);
       return ip;
     }
-    if(empty == 0 && ip->ref == 0)    // Remember empty slot.
-      empty = ip;
   }
 
-  // Recycle an inode cache entry.
-  if(empty == 0)
+  // Allocate a new cache entry.
+  if((ip = slaballoc(&icache.cache)) == 0)
     panic("iget: no inodes");
 
-  ip = empty;
   ip->dev = dev;
   ip->inum = inum;
   ip->ref = 1;
   ip->valid = 0;
+  ip->pcached = 0;
+  ip->next = *bucket;
+  *bucket = ip;
   release(&icache.lock);
 
   return ip;
@@ -322,8 +330,8 @@ iunlock(struct inode *ip)
 }
 
 // Drop a reference to an in-memory inode.
-// If that was the last reference, the inode cache entry can
-// be recycled.
+// If that was the last reference, the inode cache entry is
+// freed.
 // If that was the last reference and the inode has no links
 // to it, free the inode (and its content) on disk.
 // All calls to iput() must be inside a transaction in
@@ -331,6 +339,8 @@ iunlock(struct inode *ip)
 void
 iput(struct inode *ip)
 {
+  struct inode **pp;
+
   acquiresleep(&ip->lock);
   if(ip->valid && ip->nlink == 0){
     acquire(&icache.lock);
@@ -347,7 +357,14 @@ iput(struct inode *ip)
   releasesleep(&ip->lock);
 
   acquire(&icache.lock);
-  ip->ref--;
+  if(--ip->ref == 0){
+    for(pp = &icache.hash[ip->inum % NINODEHASH]; *pp != ip; pp = &(*pp)->next)
+      ;
+    *pp = ip->next;
+    release(&icache.lock);
+    slabfree(&icache.cache, ip);
+    return;
+  }
   release(&icache.lock);
 }
 
@@ -411,6 +428,8 @@ itrunc(struct inode *ip)
   struct buf *bp;
   uint *a;
 
+  if(ip->pcached)
+    pcinval(ip);
   for(i = 0; i < NDIRECT; i++){
     if(ip->addrs[i]){
       bfree(ip->dev, ip->addrs[i]);
@@ -494,6 +513,8 @@ writei(struct inode *ip, char *src, uint off, uint n)
     return -1;
   if(off + n > MAXFILE*BSIZE)
     return -1;
+  if(ip->pcached)
+    pcinval(ip);
 
   for(tot=0; tot<n; tot+=m, off+=m, src+=m){
     bp = bread(ip->dev, bmap(ip, off/BSIZE));
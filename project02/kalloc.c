@@ -8,6 +8,8 @@
 #include "memlayout.h"
 #include "mmu.h"
 #include "spinlock.h"
+#include "proc.h"
+#include "kmemstat.h"
 
 void freerange(void *vstart, void *vend);
 extern char end[]; // first address after kernel loaded from ELF file
@@ -17,12 +19,45 @@ struct run {
   struct run *next;
 };
 
+// Per-cpu cache of free pages. kalloc and kfree work on the
+// cache of their cpu with interrupts off, and only take kmem.lock
+// to move KCACHE_BATCH pages at once between it and the freelist.
+// kalloc only looks at its own cache and the freelist, so it can
+// fail while up to KCACHE_SIZE pages sit in each other cache.
+#define KCACHE_SIZE  64
+#define KCACHE_BATCH 32
+
+struct kcache {
+  struct run *list;
+  int n;
+  uint hits;                   // kalloc()s served by the cache
+  uint misses;                 // kalloc()s that had to refill it
+  uint drains;                 // kfree()s that found it full
+};
+
 struct {
   struct spinlock lock;
   int use_lock;
   struct run *freelist;
+  uint nfree;                  // Pages on freelist
+  uint acquires;               // Times lock was taken
+  uint contended;              // ... while another cpu held it
+  struct kcache cache[NCPU];
+  // References to each allocated page. Pages shared copy-on-write
+  // after fork have more than one; updated atomically.
+  ushort ref[PHYSTOP / PGSIZE];
 } kmem;
 
+static void
+kmemlock(void)
+{
+  // Only a hint; the counters are statistics.
+  if(kmem.lock.locked)
+    kmem.contended++;
+  acquire(&kmem.lock);
+  kmem.acquires++;
+}
+
 // Initialization happens in two phases.
 // 1. main() calls kinit1() while still using entrypgdir to place just
 // the pages mapped by entrypgdir on free list.
@@ -60,20 +95,57 @@ void
 kfree(char *v)
 {
   struct run *r;
+  struct kcache *c;
+  ushort ref;
+  int i;
 
   if((uint)v % PGSIZE || v < end || V2P(v) >= PHYSTOP)
     panic("kfree");
 
+  // A shared page is freed by its last user.
+  if(kmem.use_lock){
+    ref = __sync_sub_and_fetch(&kmem.ref[V2P(v) / PGSIZE], 1);
+    if(ref == 0xFFFF)
+      panic("kfree: ref");
+    if(ref != 0)
+      return;
+    pcfree(v);
+  }
+
   // Fill with junk to catch dangling refs.
   memset(v, 1, PGSIZE);
 
-  if(kmem.use_lock)
-    acquire(&kmem.lock);
   r = (struct run*)v;
-  r->next = kmem.freelist;
-  kmem.freelist = r;
-  if(kmem.use_lock)
+  // Before kinit2 there is only the boot cpu and no cpus[] yet.
+  if(!kmem.use_lock){
+    r->next = kmem.freelist;
+    kmem.freelist = r;
+    kmem.nfree++;
+    return;
+  }
+
+  pushcli();
+  c = &kmem.cache[cpuid()];
+  if(c->n == KCACHE_SIZE){
+    // Give the oldest half back, keeping the recently freed
+    // (cache warm) pages here.
+    c->drains++;
+    kmemlock();
+    for(i = 0; i < KCACHE_BATCH; i++){
+      r = c->list;
+      c->list = r->next;
+      r->next = kmem.freelist;
+      kmem.freelist = r;
+    }
+    kmem.nfree += KCACHE_BATCH;
     release(&kmem.lock);
+    c->n -= KCACHE_BATCH;
+    r = (struct run*)v;
+  }
+  r->next = c->list;
+  c->list = r;
+  c->n++;
+  popcli();
 }
 
 // Allocate one 4096-byte page of physical memory.
@@ -83,14 +155,95 @@ char*
 kalloc(void)
 {
   struct run *r;
+  struct kcache *c;
+  int i;
+
+  if(!kmem.use_lock){
+    r = kmem.freelist;
+    if(r){
+      kmem.freelist = r->next;
+      kmem.nfree--;
+    }
+    return (char*)r;
+  }
 
-  if(kmem.use_lock)
-    acquire(&kmem.lock);
-  r = kmem.freelist;
-  if(r)
-    kmem.freelist = r->next;
-  if(kmem.use_lock)
+  pushcli();
+  c = &kmem.cache[cpuid()];
+  if(c->n > 0)
+    c->hits++;
+  else {
+    c->misses++;
+    kmemlock();
+    for(i = 0; i < KCACHE_BATCH && kmem.freelist; i++){
+      r = kmem.freelist;
+      kmem.freelist = r->next;
+      r->next = c->list;
+      c->list = r;
+    }
+    kmem.nfree -= i;
     release(&kmem.lock);
+    c->n = i;
+  }
+  r = c->list;
+  if(r){
+    c->list = r->next;
+    c->n--;
+    kmem.ref[V2P(r) / PGSIZE] = 1;
+  }
+  popcli();
   return (char*)r;
 }
 
+// Take another reference to page v, for copy-on-write sharing.
+void
+kref(char *v)
+{
+  __sync_fetch_and_add(&kmem.ref[V2P(v) / PGSIZE], 1);
+}
+
+// Number of references to page v.
+int
+krefs(char *v)
+{
+  return kmem.ref[V2P(v) / PGSIZE];
+}
+
+// Take another reference to page v if it still has r.
+// Returns 1 if it did.
+int
+kreftry(char *v, int r)
+{
+  return __sync_bool_compare_and_swap(&kmem.ref[V2P(v) / PGSIZE], r, r + 1);
+}
+
+// Pages on the freelist, without the lock: a hint for the
+// low-water mark of swap. The per-cpu caches are left out, since
+// kalloc() cannot take pages from the cache of another cpu.
+uint
+kfreepages(void)
+{
+  return kmem.nfree;
+}
+
+// Snapshot of the allocator counters.
+// The per-cpu counters are read without locks.
+void
+getkmemstat(struct kmemstat *st)
+{
+  struct kcache *c;
+
+  memset(st, 0, sizeof(*st));
+  acquire(&kmem.lock);
+  st->nfree = kmem.nfree;
+  st->acquires = kmem.acquires;
+  st->contended = kmem.contended;
+  release(&kmem.lock);
+  for(c = kmem.cache; c < &kmem.cache[ncpu]; c++){
+    st->ncached += c->n;
+    st->hits += c->hits;
+    st->misses += c->misses;
+    st->drains += c->drains;
+  }
+  pcstat(&st->pcpages, &st->pchits, &st->pcmisses);
+  swapstat(&st->swapused, &st->swapins, &st->swapouts);
+}
@@ -0,0 +1,78 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "kmemstat.h"
+
+// Page allocator benchmark.
+// usage: kalloc_bench [workers]
+// Every worker forks short-lived children and grows and shrinks
+// its heap, so pages are allocated and freed on all cpus at once.
+// Prints the time taken, how many kalloc()s the per-cpu caches
+// served and how often kmem.lock was found held.
+// Run with CPUS=4 to see the contention.
+
+#define NUM_ITER 200
+#define SBRK_PAGES 16
+
+void
+worker(void)
+{
+  char *p;
+  int i, j, pid;
+
+  for(i = 0; i < NUM_ITER; i++){
+    pid = fork();
+    if(pid < 0){
+      printf(1, "fork failed\n");
+      exit();
+    }
+    if(pid == 0)
+      exit();
+    wait();
+
+    p = sbrk(SBRK_PAGES * 4096);
+    if(p == (char*)-1){
+      printf(1, "sbrk failed\n");
+      exit();
+    }
+    for(j = 0; j < SBRK_PAGES; j++)
+      p[j * 4096] = j;
+    sbrk(-SBRK_PAGES * 4096);
+  }
+  exit();
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct kmemstat before, after;
+  uint calls, hits, acquires;
+  int n, i, start, t;
+
+  n = 4;
+  if(argc > 1)
+    n = atoi(argv[1]);
+
+  getkmemstat(&before);
+  start = uptime();
+  for(i = 0; i < n; i++){
+    if(fork() == 0)
+      worker();
+  }
+  while(wait() != -1)
+    ;
+  t = uptime() - start;
+  getkmemstat(&after);
+
+  hits = after.hits - before.hits;
+  calls = hits + after.misses - before.misses;
+  acquires = after.acquires - before.acquires;
+  printf(1, "%d workers: %d ticks\n", n, t);
+  printf(1, "kalloc: %d calls, %d%% from the cpu cache\n",
+         calls, calls ? hits * 100 / calls : 0);
+  printf(1, "kmem.lock: %d acquires, %d contended, %d drains\n",
+         acquires, after.contended - before.contended,
+         after.drains - before.drains);
+  printf(1, "free pages: %d global, %d cached\n", after.nfree, after.ncached);
+  exit();
+}
@@ -0,0 +1,17 @@
+// Physical page allocator counters, reported by getkmemstat().
+// The counters wrap; take differences.
+struct kmemstat {
+  uint nfree;      // Free pages on the global list
+  uint ncached;    // Free pages in the per-cpu caches
+  uint hits;       // kalloc()s served by the cache of their cpu
+  uint misses;     // kalloc()s that refilled the cache from the global list
+  uint drains;     // kfree()s that gave half of a full cache back
+  uint acquires;   // Times kmem.lock was taken (after boot)
+  uint contended;  // ... while it was held by another cpu
+  uint pcpages;    // Program pages shared through the page cache
+  uint pchits;     // Program page faults served by the page cache
+  uint pcmisses;   // ... that read the page from the file
+  uint swapused;   // Swap slots in use
+  uint swapins;    // Pages read back from swap
+  uint swapouts;   // Pages written to swap
+};
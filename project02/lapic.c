@@ -123,6 +123,17 @@ microdelay(int us)
 #define CMOS_PORT    0x70
 #define CMOS_RETURN  0x71
 
+// Send interrupt vector to the cpu with apicid.
+// Caller has interrupts off.
+void
+lapicipi(int apicid, int vector)
+{
+  lapicw(ICRHI, apicid<<24);
+  lapicw(ICRLO, FIXED | ASSERT | vector);
+  while(lapic[ICRLO] & DELIVS)
+    ;
+}
+
 // Start additional processor running entry code at addr.
 // See Appendix B of MultiProcessor Specification.
 void
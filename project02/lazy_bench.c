@@ -0,0 +1,98 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "kmemstat.h"
+
+// Lazy sbrk benchmark.
+// Reserves a large heap with sbrk, then touches one page in every
+// STRIDE, and prints the time and the pages taken by each step:
+// only the touched pages should cost anything.
+// Then checks that memlim is enforced on touched pages: a child
+// with a limit may reserve more than the limit, but is killed
+// when it touches more.
+
+#define HEAP (64 * 1024 * 1024)
+#define STRIDE 64
+
+uint
+freepages(void)
+{
+  struct kmemstat st;
+
+  getkmemstat(&st);
+  return st.nfree + st.ncached;
+}
+
+void
+sparse(void)
+{
+  char *p;
+  uint before;
+  int i, start;
+
+  before = freepages();
+  start = uptime();
+  p = sbrk(HEAP);
+  if(p == (char*)-1){
+    printf(1, "sbrk failed\n");
+    exit();
+  }
+  printf(1, "sbrk(%dMiB): %d ticks, %d pages\n",
+         HEAP / (1024 * 1024), uptime() - start, before - freepages());
+
+  before = freepages();
+  start = uptime();
+  for(i = 0; i < HEAP; i += STRIDE * 4096)
+    p[i] = 1;
+  printf(1, "touched 1 page in %d: %d ticks, %d pages\n",
+         STRIDE, uptime() - start, before - freepages());
+  sbrk(-HEAP);
+}
+
+// The child reports over a pipe how far it got; if it was killed
+// as it should be, the parent reads nothing.
+void
+limit(void)
+{
+  char *p, c;
+  int i, fds[2];
+
+  if(pipe(fds) < 0){
+    printf(1, "memlim: FAIL, pipe failed\n");
+    exit();
+  }
+  if(fork() == 0){
+    close(fds[0]);
+    setmemorylimit(getpid(), 1024 * 1024);
+    p = sbrk(4 * 1024 * 1024);
+    if(p == (char*)-1){
+      write(fds[1], "s", 1);
+      exit();
+    }
+    printf(1, "memlim: reserved 4MiB under a 1MiB limit\n");
+    for(i = 0; i < 4 * 1024 * 1024; i += 4096)
+      p[i] = 1;
+    write(fds[1], "t", 1);
+    exit();
+  }
+  close(fds[1]);
+  if(read(fds[0], &c, 1) == 1){
+    if(c == 's')
+      printf(1, "memlim: FAIL, sbrk over the limit was refused\n");
+    else
+      printf(1, "memlim: FAIL, touched 4MiB under a 1MiB limit\n");
+    wait();
+    exit();
+  }
+  close(fds[0]);
+  wait();
+  printf(1, "memlim: ok, child killed at the limit\n");
+}
+
+int
+main(int argc, char *argv[])
+{
+  sparse();
+  limit();
+  exit();
+}
@@ -18,7 +18,7 @@
 #define NINODES 200
 
 // Disk layout:
-// [ boot block | sb block | log | inode blocks | free bit map | data blocks ]
+// [ boot block | sb block | log | inode blocks | free bit map | data blocks | swap ]
 
 int nbitmap = FSSIZE/(BSIZE*8) + 1;
 int ninodeblocks = NINODES / IPB + 1;
@@ -101,14 +101,21 @@ main(int argc, char *argv[])
   sb.logstart = xint(2);
   sb.inodestart = xint(2+nlog);
   sb.bmapstart = xint(2+nlog+ninodeblocks);
+  sb.swapstart = xint(FSSIZE);
+  sb.nswap = xint(NSWAP);
 
-  printf("nmeta %d (boot, super, log blocks %u inode blocks %u, bitmap blocks %u) blocks %d total %d\n",
-         nmeta, nlog, ninodeblocks, nbitmap, nblocks, FSSIZE);
+  printf("nmeta %d (boot, super, log blocks %u inode blocks %u, bitmap blocks %u) blocks %d total %d swap blocks %d\n",
+         nmeta, nlog, ninodeblocks, nbitmap, nblocks, FSSIZE, SWAPSIZE);
 
   freeblock = nmeta;     // the first free block that we can allocate
 
   for(i = 0; i < FSSIZE; i++)
     wsect(i, zeroes);
+  // The swap area needs no contents; leave it a hole in the file.
+  if(ftruncate(fsfd, (off_t)(FSSIZE + SWAPSIZE) * BSIZE) < 0){
+    perror("ftruncate");
+    exit(1);
+  }
 
   memset(buf, 0, sizeof(buf));
   memmove(buf, &sb, sizeof(sb));
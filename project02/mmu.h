@@ -17,9 +17,10 @@
 #define SEG_UCODE 3  // user code
 #define SEG_UDATA 4  // user data+stack
 #define SEG_TSS   5  // this process's task state
+#define SEG_UTLS  6  // user thread-local storage, at %gs
 
 // cpu->gdt[NSEGS] holds the above segments.
-#define NSEGS     6
+#define NSEGS     7
 
 #ifndef __ASSEMBLER__
 // Segment Descriptor
@@ -94,12 +95,23 @@ struct segdesc {
 #define PTE_P           0x001   // Present
 #define PTE_W           0x002   // Writeable
 #define PTE_U           0x004   // User
+#define PTE_A           0x020   // Accessed
 #define PTE_PS          0x080   // Page Size
+#define PTE_COW         0x200   // Copy-on-write (bit available to software)
+#define PTE_SWAP        0x400   // Not present, in swap (bit available to software)
+#define PTE_FUTEX       0x800   // Waited on as a futex; fork copies it (software)
+
+// Page fault error code
+#define FEC_P           0x001   // Page was present (protection fault)
+#define FEC_WR          0x002   // Caused by a write
 
 // Address in page table or page directory entry
 #define PTE_ADDR(pte)   ((uint)(pte) & ~0xFFF)
 #define PTE_FLAGS(pte)  ((uint)(pte) &  0xFFF)
 
+// Swap slot in a PTE_SWAP entry
+#define PTE_SLOT(pte)   ((uint)(pte) >> PTXSHIFT)
+
 #ifndef __ASSEMBLER__
 typedef uint pte_t;
 
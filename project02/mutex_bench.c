@@ -0,0 +1,109 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "x86.h"
+
+// Contended mutex benchmark.
+// usage: mutex_bench [maxthreads]
+// n threads share a counter and do a fixed number of increments
+// in total, each one in a short critical section. Compares the
+// futex-based mutex of ulib with a plain spinlock: a thread that
+// waits for the mutex sleeps, while a spinner burns the rest of
+// its time slice when the holder is preempted. The threads start
+// together at a barrier.
+
+#define OPS 200000
+#define WORK 50
+#define MAXTHREAD 16
+
+struct mutex mutex;
+volatile uint spin;
+struct barrier start;
+volatile uint counter;
+volatile int sink;
+int nthread, usespin;
+thread_t tids[MAXTHREAD];
+
+void
+lock(void)
+{
+  if(usespin){
+    while(xchg(&spin, 1) != 0)
+      ;
+  } else
+    mutex_lock(&mutex);
+}
+
+void
+unlock(void)
+{
+  if(usespin)
+    xchg(&spin, 0);
+  else
+    mutex_unlock(&mutex);
+}
+
+void*
+worker(void *arg)
+{
+  int i, j;
+
+  barrier_wait(&start);
+  for(i = 0; i < OPS / nthread; i++){
+    lock();
+    for(j = 0; j < WORK; j++)
+      sink = j;
+    counter++;
+    unlock();
+  }
+  thread_exit(0);
+  return 0;
+}
+
+// Ticks for OPS increments by n threads.
+int
+run(int n, int spinning)
+{
+  int i, t;
+  void *ret;
+
+  nthread = n;
+  usespin = spinning;
+  counter = 0;
+  mutex_init(&mutex);
+  spin = 0;
+  barrier_init(&start, n + 1);
+  for(i = 0; i < n; i++){
+    if(thread_create(&tids[i], worker, 0) != 0){
+      printf(1, "thread_create failed\n");
+      exit();
+    }
+  }
+  t = uptime();
+  barrier_wait(&start);
+  for(i = 0; i < n; i++)
+    thread_join(tids[i], &ret);
+  t = uptime() - t;
+  if(counter != (OPS / n) * n){
+    printf(1, "lost updates: %d of %d\n", counter, (OPS / n) * n);
+    exit();
+  }
+  return t;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int max, n;
+
+  max = 8;
+  if(argc > 1)
+    max = atoi(argv[1]);
+  if(max < 1 || max > MAXTHREAD)
+    max = MAXTHREAD;
+
+  printf(1, "threads  mutex ticks  spinlock ticks\n");
+  for(n = 1; n <= max; n *= 2)
+    printf(1, "%d  %d  %d\n", n, run(n, 0), run(n, 1));
+  exit();
+}
@@ -1,9 +1,8 @@
 #define NPROC        64  // maximum number of processes
+#define NTHREAD    1024  // maximum threads per process
 #define KSTACKSIZE 4096  // size of per-process kernel stack
 #define NCPU          8  // maximum number of CPUs
 #define NOFILE       16  // open files per process
-#define NFILE       100  // open files per system
-#define NINODE       50  // maximum number of active i-nodes
 #define NDEV         10  // maximum major device number
 #define ROOTDEV       1  // device number of file system root disk
 #define MAXARG       32  // max exec arguments
@@ -11,4 +10,6 @@
 #define LOGSIZE      (MAXOPBLOCKS*3)  // max data blocks in on-disk log
 #define NBUF         (MAXOPBLOCKS*3)  // size of disk block cache
 #define FSSIZE       1000  // size of file system in blocks
+#define NSWAP        65536  // size of swap area in pages
+#define SWAPSIZE     (NSWAP*8)  // ... in blocks, after the file system
 
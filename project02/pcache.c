@@ -0,0 +1,208 @@
+// Cache of program pages read from executables.
+//
+// exec maps the pages of a program on first touch (see execfault
+// in vm.c). A page read from an executable is entered here by
+// inode and file offset, so other processes running the same
+// binary map the same physical page instead of reading their own.
+// The page is mapped read-only and PTE_COW, so a process that
+// writes to it (a data page) gets a private copy.
+//
+// The cache holds no reference of its own: when the last process
+// mapping a page frees it (freevm, deallocuvm), kfree() calls
+// pcfree() to drop the entry. pcget() never takes a reference to
+// a page whose count already reached zero.
+// Writing to or truncating an executable drops its entries;
+// processes keep the pages they already mapped.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "fs.h"
+#include "file.h"
+#include "slab.h"
+
+#define NPCHASH 128
+
+struct pcpage {
+  uint dev;
+  uint inum;
+  uint off;                    // File offset of the page
+  char *page;
+  struct pcpage *next;         // in the bucket of its key
+  struct pcpage *pnext;        // in the bucket of its page
+};
+
+static struct {
+  struct spinlock lock;
+  struct slabcache cache;
+  struct pcpage *key[NPCHASH];
+  struct pcpage *pg[NPCHASH];
+  uint npages;
+  uint hits;
+  uint misses;
+} pc;
+
+// Set for pages in the cache, so kfree() can tell without the lock.
+static uchar cached[PHYSTOP / PGSIZE];
+
+#define KEYHASH(dev, inum, off) (((inum) * 31 + (off) / PGSIZE + (dev)) % NPCHASH)
+#define PGHASH(v) ((V2P(v) / PGSIZE) % NPCHASH)
+
+void
+pcinit(void)
+{
+  initlock(&pc.lock, "pcache");
+  slabinit(&pc.cache, "pcpage", sizeof(struct pcpage), 0);
+}
+
+// Take a reference to v unless its count already dropped to zero.
+static int
+krefget(char *v)
+{
+  int r;
+
+  while((r = krefs(v)) != 0)
+    if(kreftry(v, r))
+      return 1;
+  return 0;
+}
+
+// The cached page of ip at file offset off, with a reference
+// taken for the caller, or 0.
+char*
+pcget(struct inode *ip, uint off)
+{
+  struct pcpage *e;
+  char *v = 0;
+
+  acquire(&pc.lock);
+  for(e = pc.key[KEYHASH(ip->dev, ip->inum, off)]; e; e = e->next){
+    if(e->dev == ip->dev && e->inum == ip->inum && e->off == off){
+      if(krefget(e->page))
+        v = e->page;
+      break;
+    }
+  }
+  if(v)
+    pc.hits++;
+  else
+    pc.misses++;
+  release(&pc.lock);
+  return v;
+}
+
+// Enter page v, just read from ip at off, in the cache.
+// If another process entered the same page first, returns that
+// page with a reference taken, and the caller frees v;
+// otherwise returns v.
+char*
+pcadd(struct inode *ip, uint off, char *v)
+{
+  struct pcpage *e;
+  uint h = KEYHASH(ip->dev, ip->inum, off);
+
+  acquire(&pc.lock);
+  for(e = pc.key[h]; e; e = e->next){
+    if(e->dev == ip->dev && e->inum == ip->inum && e->off == off){
+      if(krefget(e->page)){
+        release(&pc.lock);
+        return e->page;
+      }
+      break;
+    }
+  }
+  // A stale entry is still there if its page is being freed;
+  // pcfree() only drops the entry that points to that page.
+  if((e = slaballoc(&pc.cache)) != 0){
+    e->dev = ip->dev;
+    e->inum = ip->inum;
+    e->off = off;
+    e->page = v;
+    e->next = pc.key[h];
+    pc.key[h] = e;
+    e->pnext = pc.pg[PGHASH(v)];
+    pc.pg[PGHASH(v)] = e;
+    cached[V2P(v) / PGSIZE] = 1;
+    pc.npages++;
+    ip->pcached = 1;
+  }
+  release(&pc.lock);
+  return v;
+}
+
+// Caller must hold pc.lock.
+static void
+pcremove(struct pcpage *e)
+{
+  struct pcpage **pp;
+
+  for(pp = &pc.key[KEYHASH(e->dev, e->inum, e->off)]; *pp != e; pp = &(*pp)->next)
+    ;
+  *pp = e->next;
+  for(pp = &pc.pg[PGHASH(e->page)]; *pp != e; pp = &(*pp)->pnext)
+    ;
+  *pp = e->pnext;
+  cached[V2P(e->page) / PGSIZE] = 0;
+  pc.npages--;
+  slabfree(&pc.cache, e);
+}
+
+// Is page v in the cache? Such a page must be copied, not made
+// writable, even by its only user.
+int
+pccached(char *v)
+{
+  return cached[V2P(v) / PGSIZE];
+}
+
+// Called by kfree() when the last reference to v is dropped.
+void
+pcfree(char *v)
+{
+  struct pcpage *e;
+
+  if(!cached[V2P(v) / PGSIZE])
+    return;
+  acquire(&pc.lock);
+  for(e = pc.pg[PGHASH(v)]; e; e = e->pnext){
+    if(e->page == v){
+      pcremove(e);
+      break;
+    }
+  }
+  release(&pc.lock);
+}
+
+// Drop the cached pages of ip, which is being written or truncated.
+void
+pcinval(struct inode *ip)
+{
+  struct pcpage *e, *next;
+  int i;
+
+  acquire(&pc.lock);
+  for(i = 0; i < NPCHASH; i++){
+    for(e = pc.key[i]; e; e = next){
+      next = e->next;
+      if(e->dev == ip->dev && e->inum == ip->inum)
+        pcremove(e);
+    }
+  }
+  ip->pcached = 0;
+  release(&pc.lock);
+}
+
+// Snapshot of the cache counters.
+void
+pcstat(uint *npages, uint *hits, uint *misses)
+{
+  acquire(&pc.lock);
+  *npages = pc.npages;
+  *hits = pc.hits;
+  *misses = pc.misses;
+  release(&pc.lock);
+}
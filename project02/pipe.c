@@ -7,6 +7,7 @@
 #include "spinlock.h"
 #include "sleeplock.h"
 #include "file.h"
+#include "slab.h"
 
 #define PIPESIZE 512
 
@@ -19,6 +20,21 @@ struct pipe {
   int writeopen;  // write fd is still open
 };
 
+// A pipe is about 540 bytes; a page holds 7 of them.
+static struct slabcache pipecache;
+
+static void
+pipector(void *v)
+{
+  initlock(&((struct pipe*)v)->lock, "pipe");
+}
+
+void
+pipeinit(void)
+{
+  slabinit(&pipecache, "pipe", sizeof(struct pipe), pipector);
+}
+
 int
 pipealloc(struct file **f0, struct file **f1)
 {
@@ -28,13 +44,12 @@ pipealloc(struct file **f0, struct file **f1)
   *f0 = *f1 = 0;
   if((*f0 = filealloc()) == 0 || (*f1 = filealloc()) == 0)
     goto bad;
-  if((p = (struct pipe*)kalloc()) == 0)
+  if((p = slaballoc(&pipecache)) == 0)
     goto bad;
   p->readopen = 1;
   p->writeopen = 1;
   p->nwrite = 0;
   p->nread = 0;
-  initlock(&p->lock, "pipe");
   (*f0)->type = FD_PIPE;
   (*f0)->readable = 1;
   (*f0)->writable = 0;
@@ -48,7 +63,7 @@ pipealloc(struct file **f0, struct file **f1)
 //PAGEBREAK: 20
  bad:
   if(p)
-    kfree((char*)p);
+    slabfree(&pipecache, p);
   if(*f0)
     fileclose(*f0);
   if(*f1)
@@ -69,7 +84,7 @@ pipeclose(struct pipe *p, int writable)
   }
   if(p->readopen == 0 && p->writeopen == 0){
     release(&p->lock);
-    kfree((char*)p);
+    slabfree(&pipecache, p);
   } else
     release(&p->lock);
 }
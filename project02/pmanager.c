@@ -3,6 +3,7 @@
 #include "types.h"
 #include "user.h"
 #include "fcntl.h"
+#include "procstat.h"
 
 // Parsed command representation
 #define EXEC  1
@@ -12,6 +13,8 @@
 #define BACK  5
 
 #define MAXARGS 10
+#define MAXPROC 64
+#define MAXTHREAD 1024   // NTHREAD in param.h
 
 int stacksize;
 
@@ -143,12 +146,60 @@ getcmd(char *buf, int nbuf)
   return 0;
 }
 
+// list
+// running, runnable 상태인 process의 정보와 실제 메모리 사용량(page 단위),
+// page fault 횟수를 출력한다. rss는 memlim과 비교되는 값이다.
+void
+listproc(void)
+{
+  static struct procstat ps[MAXPROC];
+  int i, n;
+
+  if((n = getprocstat(ps, MAXPROC)) < 0){
+    printf(1, "[list] Fail\n");
+    return;
+  }
+  printf(1, "[Process Information]\n");
+  printf(1, "name pid ssize sz memlim | rss resident shared swapped ptpages threads | cow lazy exec swapin\n");
+  for(i = 0; i < n; i++){
+    // RUNNABLE(3), RUNNING(4)
+    if(ps[i].state != 3 && ps[i].state != 4)
+      continue;
+    printf(1, "%s %d %d %d %d | %d %d %d %d %d %d | %d %d %d %d\n",
+           ps[i].name, ps[i].pid, ps[i].ssize, ps[i].sz, ps[i].memlim,
+           ps[i].rss, ps[i].resident, ps[i].shared, ps[i].swapped,
+           ps[i].ptpages, ps[i].nthread,
+           ps[i].cow, ps[i].lazy, ps[i].exec, ps[i].swapin);
+  }
+}
+
+// threads
+// pid에 해당하는 process의 thread별 stack page 수와 page fault 횟수를 출력한다.
+void
+listthreads(int pid)
+{
+  static struct threadstat ts[MAXTHREAD];
+  int i, n;
+
+  if((n = getthreadstat(pid, ts, MAXTHREAD)) < 0){
+    printf(1, "[threads] Fail\n");
+    return;
+  }
+  printf(1, "[Thread Information]\n");
+  printf(1, "tid state stack ssize | cow lazy exec swapin\n");
+  for(i = 0; i < n; i++)
+    printf(1, "%d %d %x %d | %d %d %d %d\n",
+           ts[i].tid, ts[i].state, ts[i].stack, ts[i].ssize,
+           ts[i].cow, ts[i].lazy, ts[i].exec, ts[i].swapin);
+}
+
 // help
 // 도움말을 출력해주는 기능 (부가)
 void help(void)
 {
   printf(1, "******************************************* HELP *******************************************\n");
-  printf(1, "* - list : print information of running & runnable process                                 *\n");
+  printf(1, "* - list : print memory and page faults of running & runnable processes                    *\n");
+  printf(1, "* - threads <pid> : print stack pages and page faults of each thread of the process        *\n");
   printf(1, "* - kill <pid> : kill the process corresponding to the pid                                 *\n");
   printf(1, "* - execute <path> <stacksize> : execute the program located in the path with stacksize    *\n");
   printf(1, "* - memlim <pid> <limit> : Set the memlim of the process corresponding to the pid to limit *\n");
@@ -186,7 +237,12 @@ main(void)
     // runnable or running 상태인 process들을 출력한다.
     else if(!strcmp(cmd, "list"))
     {
-      list();
+      listproc();
+    }
+    // pid에 해당하는 process의 thread들을 출력한다.
+    else if(!strcmp(cmd, "threads"))
+    {
+      listthreads(atoi(my_strtok(0, " ")));
     }
     // pid에 해당하는 process를 제거한다.
     else if(!strcmp(cmd, "kill"))
@@ -6,13 +6,75 @@
 #include "x86.h"
 #include "proc.h"
 #include "spinlock.h"
+#include "slab.h"
+#include "procstat.h"
+#include "threadattr.h"
+
+// Wait channels
+// Sleeping threads are chained in a bucket chosen by hashing
+// their chan, so wakeup() only visits threads that may be
+// sleeping on it instead of every thread of every process.
+#define NSLEEPQ_SHIFT 6
+#define NSLEEPQ (1 << NSLEEPQ_SHIFT)
+
+// Run queue
+// Every RUNNABLE thread, of any process, is on a single FIFO
+// queue; scheduler() runs the thread at its head and yield()
+// puts the current one back at its tail. CPU time is shared
+// per thread, so a process gets a share for each of its threads,
+// and threads of one process run on several cpus at once.
 
 struct {
   struct spinlock lock;
   struct proc proc[NPROC];
+  struct thread *sleepq[NSLEEPQ];  // Heads of the wait-channel buckets
+  struct thread *runhead;          // Run queue
+  struct thread *runtail;
 } ptable;
 
+// Bucket of the given wait channel
+static struct thread**
+sleepq_of(void *chan)
+{
+  return &ptable.sleepq[((uint)chan * 2654435761U) >> (32 - NSLEEPQ_SHIFT)];
+}
+
+// Make t RUNNABLE and put it at the tail of the run queue.
+// The ptable lock must be held.
+static void
+setrunnable(struct thread *t)
+{
+  t->state = RUNNABLE;
+  t->runnext = 0;
+  t->runprev = ptable.runtail;
+  if(ptable.runtail)
+    ptable.runtail->runnext = t;
+  else
+    ptable.runhead = t;
+  ptable.runtail = t;
+}
+
+// Take a RUNNABLE thread off the run queue before its state is
+// changed other than by scheduler().
+// The ptable lock must be held.
+static void
+unqueue(struct thread *t)
+{
+  if(t->state != RUNNABLE)
+    return;
+  if(t->runprev)
+    t->runprev->runnext = t->runnext;
+  else
+    ptable.runhead = t->runnext;
+  if(t->runnext)
+    t->runnext->runprev = t->runprev;
+  else
+    ptable.runtail = t->runprev;
+  t->runnext = t->runprev = 0;
+}
+
 static struct proc *initproc;
+static struct slabcache threadcache;
 
 int nextpid = 1;
 thread_t nexttid = 1; // nexttid like nextpid in proc.c
@@ -20,6 +82,11 @@ extern void forkret(void);
 extern void trapret(void);
 
 static void wakeup1(void *chan);
+static void unsleep(struct thread *t);
+static void putthread(struct thread *t);
+
+// If zero, fork copies the whole image eagerly (see setcowfork).
+static int cowfork = 1;
 
 // memorylimit system call
 int 
@@ -41,7 +108,7 @@ setmemorylimit(int pid, int limit)
   
   // Set limit of process corresponding to pid second argument named limit
   for(p = ptable.proc; p < &ptable.proc[NPROC]; p++)
-    if(p->pid == pid && p->sz <= limit)
+    if(p->pid == pid && p->rss * PGSIZE <= limit)
     {
       // Set limit and ret
       p->memlim = limit;
@@ -73,10 +140,99 @@ list(void)
   release(&ptable.lock);
 }
 
+// Memory and fault statistics of up to n processes, for pmanager,
+// copied out to the user array ps.
+// Returns the number filled in, or -1.
+int
+getprocstat(struct procstat *ps, int n)
+{
+  struct proc *p, *curproc = myproc();
+  struct procstat s;
+  int k = 0;
+
+  acquire(&ptable.lock);
+  for(p = ptable.proc; p < &ptable.proc[NPROC] && k < n; p++){
+    if(p->state == UNUSED || p->state == EMBRYO || p->state == ZOMBIE)
+      continue;
+    s.pid = p->pid;
+    safestrcpy(s.name, p->name, sizeof(s.name));
+    s.state = mainthread(p)->state;
+    s.sz = p->sz;
+    s.memlim = p->memlim;
+    s.rss = p->rss;
+    uvmstat(p->pgdir, p->sz, &s);
+    s.ssize = p->ssize;
+    s.nthread = p->nthread;
+    s.cow = p->faults.cow;
+    s.lazy = p->faults.lazy;
+    s.exec = p->faults.exec;
+    s.swapin = p->faults.swapin;
+    if(copyout(curproc->pgdir, (uint)&ps[k], &s, sizeof(s)) < 0){
+      release(&ptable.lock);
+      return -1;
+    }
+    k++;
+  }
+  release(&ptable.lock);
+  return k;
+}
+
+// Statistics of up to n threads of process pid, copied out to the
+// user array ts. n is at most NTHREAD, which covers every thread
+// a process can have.
+// Returns the number filled in, or -1 if there is no such process.
+int
+getthreadstat(int pid, struct threadstat *ts, int n)
+{
+  struct proc *p, *curproc = myproc();
+  struct thread *t;
+  struct threadstat s;
+  int k, others;
+
+  acquire(&ptable.lock);
+  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+    if(p->pid == pid && p->state != UNUSED && p->state != EMBRYO)
+      break;
+  if(p == &ptable.proc[NPROC]){
+    release(&ptable.lock);
+    return -1;
+  }
+  // The main thread has the part of p->ssize that is not the
+  // stack of another thread.
+  others = 0;
+  for(t = p->threads; t; t = t->next)
+    if(t != p->main)
+      others += t->stackpages;
+  for(t = p->freethreads; t; t = t->next)
+    others += t->stackpages;
+  k = 0;
+  for(t = p->threads; t && k < n; t = t->next){
+    s.tid = t->tid;
+    s.state = t->state;
+    s.stack = t->ustack;
+    if(t == p->main)
+      s.ssize = p->ssize - others;
+    else
+      s.ssize = t->stackpages;
+    s.cow = t->faults.cow;
+    s.lazy = t->faults.lazy;
+    s.exec = t->faults.exec;
+    s.swapin = t->faults.swapin;
+    if(copyout(curproc->pgdir, (uint)&ts[k], &s, sizeof(s)) < 0){
+      release(&ptable.lock);
+      return -1;
+    }
+    k++;
+  }
+  release(&ptable.lock);
+  return k;
+}
+
 void
 pinit(void)
 {
   initlock(&ptable.lock, "ptable");
+  slabinit(&threadcache, "thread", sizeof(struct thread), 0);
 }
 
 // Must be called with interrupts disabled
@@ -119,18 +275,135 @@ myproc(void) {
 }
 
 // Return Main thread of p
-// Return 0th thread of thread list of process
 // process의 main thread의 주소를 return한다.
 struct thread*
 mainthread(struct proc* p) {
-  return &p->ttable[p->mainidx];
+  return p->main;
 }
 
-// Return current thread of p like myproc function
-// process의 작동중인 thread의 주소를 return한다.
+// Return current thread like myproc function
+// 현재 cpu에서 작동중인 thread의 주소를 return한다.
+// Threads of one process may run on several cpus at once,
+// so this is kept per cpu, not per process.
 struct thread*
-mythread(struct proc* p) {
-  return &p->ttable[p->rectidx];
+mythread(void) {
+  struct cpu *c;
+  struct thread *t;
+  pushcli();
+  c = mycpu();
+  t = c->thread;
+  popcli();
+  return t;
+}
+
+// Take t off the thread list of its process.
+// Caller holds ptable.lock.
+static void
+unlinkthread(struct thread *t)
+{
+  struct proc *p = t->proc;
+
+  if(t->prev)
+    t->prev->next = t->next;
+  else
+    p->threads = t->next;
+  if(t->next)
+    t->next->prev = t->prev;
+  t->next = t->prev = 0;
+  p->nthread--;
+}
+
+// Allocate a thread for p, with a kernel stack set up to start
+// executing at forkret, and put it on p's thread list. A joined
+// thread of p is reused, with its user stack and TLS, if they
+// have at least stackpages and tlspages pages.
+// Caller holds ptable.lock.
+// Returns 0 if p has NTHREAD threads or there is no memory.
+static struct thread*
+allocthread(struct proc *p, int stackpages, int tlspages)
+{
+  struct thread *t, **pp;
+  char *sp;
+
+  if(p->nthread >= NTHREAD)
+    return 0;
+  for(pp = &p->freethreads; (t = *pp) != 0; pp = &t->next)
+    if(t->stackpages >= stackpages && t->tlspages >= tlspages)
+      break;
+  if(t)
+    *pp = t->next;
+  else if((t = slaballoc(&threadcache)) != 0){
+    memset(t, 0, sizeof(*t));
+    t->proc = p;
+  } else
+    return 0;
+  t->prev = 0;
+  t->next = p->threads;
+  if(p->threads)
+    p->threads->prev = t;
+  p->threads = t;
+  p->nthread++;
+
+  t->tid = nexttid++;
+  t->state = EMBRYO;
+  t->retval = 0;
+  t->insyscall = 0;
+  memset(&t->faults, 0, sizeof(t->faults));
+
+  // Allocate kernel stack.
+  if((t->kstack = kalloc()) == 0){
+    putthread(t);
+    return 0;
+  }
+  sp = t->kstack + KSTACKSIZE;
+
+  // Leave room for trap frame.
+  sp -= sizeof *t->tf;
+  t->tf = (struct trapframe*)sp;
+
+  // Set up new context to start executing at forkret,
+  // which returns to trapret.
+  sp -= 4;
+  *(uint*)sp = (uint)trapret;
+
+  sp -= sizeof *t->context;
+  t->context = (struct context*)sp;
+  memset(t->context, 0, sizeof *t->context);
+  t->context->eip = (uint)forkret;
+  return t;
+}
+
+// Release t's kernel stack and move it to freethreads, keeping
+// its user stack for the next thread_create().
+// Caller holds ptable.lock.
+static void
+putthread(struct thread *t)
+{
+  struct proc *p = t->proc;
+
+  unlinkthread(t);
+  if(t->kstack)
+    kfree(t->kstack);
+  t->kstack = 0;
+  t->tid = 0;
+  t->state = UNUSED;
+  t->next = p->freethreads;
+  p->freethreads = t;
+}
+
+// Free a list of threads linked by next, kernel stacks and all.
+// Caller holds ptable.lock.
+static void
+freethreads(struct thread *t)
+{
+  struct thread *next;
+
+  for(; t; t = next){
+    next = t->next;
+    if(t->kstack)
+      kfree(t->kstack);
+    slabfree(&threadcache, t);
+  }
 }
 
 //PAGEBREAK: 32
@@ -142,8 +415,6 @@ static struct proc*
 allocproc(void)
 {
   struct proc *p;
-  struct thread *t;
-  char *sp;
   
   acquire(&ptable.lock);
 
@@ -155,42 +426,26 @@ allocproc(void)
   return 0;
 
 found:
-  t = mainthread(p);
-
   p->state = EMBRYO;
   p->pid = nextpid++;
   p->memlim = 0;
+  p->rss = 0;
+  p->exe = 0;
+  p->nseg = 0;
   p->ssize = 0;
-  p->rectidx = 0;
-  p->nextidx = 0;
-  p->mainidx = 0;
-  memset(p->_ustack, 0, sizeof(uint) * NPROC);
-
-  t->tid = nexttid++;
-  t->state = EMBRYO;
-
-  // Allocate kernel stack.
-  if((t->kstack = kalloc()) == 0){
-    t->state = UNUSED;
+  memset(&p->faults, 0, sizeof(p->faults));
+  p->threads = 0;
+  p->freethreads = 0;
+  p->nthread = 0;
+
+  // Allocate main thread.
+  if((p->main = allocthread(p, 0, 0)) == 0){
+    freethreads(p->freethreads);
+    p->freethreads = 0;
     p->state = UNUSED;
     release(&ptable.lock);
     return 0;
   }
-  sp = t->kstack + KSTACKSIZE;
-
-  // Leave room for trap frame.
-  sp -= sizeof *t->tf;
-  t->tf = (struct trapframe*)sp;
-
-  // Set up new context to start executing at forkret,
-  // which returns to trapret.
-  sp -= 4;
-  *(uint*)sp = (uint)trapret;
-
-  sp -= sizeof *t->context;
-  t->context = (struct context*)sp;
-  memset(t->context, 0, sizeof *t->context);
-  t->context->eip = (uint)forkret;
   
   release(&ptable.lock);
 
@@ -213,7 +468,8 @@ userinit(void)
     panic("userinit: out of memory?");
   inituvm(p->pgdir, _binary_initcode_start, (int)_binary_initcode_size);
   p->sz = PGSIZE;
-  p->_ustack[t-p->ttable] = PGSIZE;
+  p->rss = 1;
+  t->ustack = PGSIZE;
   memset(t->tf, 0, sizeof(*t->tf));
   t->tf->cs = (SEG_UCODE << 3) | DPL_USER;
   t->tf->ds = (SEG_UDATA << 3) | DPL_USER;
@@ -233,12 +489,14 @@ userinit(void)
   acquire(&ptable.lock);
 
   p->state = RUNNABLE;
-  t->state = RUNNABLE;
+  setrunnable(t);
 
   release(&ptable.lock);
 }
 
 // Grow current process's memory by n bytes.
+// Growing only reserves the address space: pagefault() maps
+// each page on first touch, and checks memlim then.
 // Return 0 on success, -1 on failure.
 int
 growproc(int n)
@@ -246,12 +504,12 @@ growproc(int n)
   uint sz;
   struct proc *curproc = myproc();
   sz = curproc->sz;
-  if(curproc->memlim != 0 && curproc->memlim < sz + n)
-    return -1;
   if(n > 0){
-    if((sz = allocuvm(curproc->pgdir, sz, sz + n)) == 0)
+    if(sz + n < sz || sz + n >= KERNBASE)
       return -1;
+    sz += n;
   } else if(n < 0){
+    curproc->rss -= uvmresident(curproc->pgdir, sz + n, sz);
     if((sz = deallocuvm(curproc->pgdir, sz, sz + n)) == 0)
       return -1;
   }
@@ -266,11 +524,11 @@ growproc(int n)
 int
 fork(void)
 {
-  int i, pid;
+  int i, pid, cow;
   struct proc *np;
   struct proc *curproc = myproc();
-  struct thread *nt;
-  struct thread *curthread = mythread(curproc);
+  struct thread *nt, *t, *ft;
+  struct thread *curthread = mythread();
 
   // Allocate process.
   if((np = allocproc()) == 0){
@@ -279,11 +537,28 @@ fork(void)
 
   nt = mainthread(np);
   // Copy process state from proc.
-  if((np->pgdir = copyuvm(curproc->pgdir, curproc->sz)) == 0){
-    kfree(nt->kstack);
-    nt->kstack = 0;
-    nt->state = UNUSED;
+  // The pages are shared copy-on-write, unless another thread of
+  // curproc is running on some cpu: it could go on writing through
+  // TLB entries made before the pages became read-only, which the
+  // child would see. ptable.lock keeps the others from starting.
+  acquire(&ptable.lock);
+  cow = cowfork;
+  for(t = curproc->threads; t; t = t->next)
+    if(t != curthread && t->state == RUNNING)
+      cow = 0;
+  if(cow)
+    np->pgdir = cowuvm(curproc->pgdir, curproc->sz);
+  release(&ptable.lock);
+  if(!cow)
+    np->pgdir = copyuvm(curproc->pgdir, curproc->sz);
+  if(np->pgdir == 0){
+    acquire(&ptable.lock);
+    freethreads(np->threads);
+    freethreads(np->freethreads);
+    np->threads = np->freethreads = np->main = 0;
+    np->nthread = 0;
     np->state = UNUSED;
+    release(&ptable.lock);
     return -1;
   }
   np->sz = curproc->sz;
@@ -292,6 +567,11 @@ fork(void)
   
   // copy memory limit variable
   np->memlim = curproc->memlim;
+  np->rss = curproc->rss;
+  if(curproc->exe)
+    np->exe = idup(curproc->exe);
+  memmove(np->seg, curproc->seg, sizeof(curproc->seg));
+  np->nseg = curproc->nseg;
   
   // Clear %eax so that fork returns 0 in the child.
   nt->tf->eax = 0;
@@ -308,19 +588,31 @@ fork(void)
   acquire(&ptable.lock);
 
   // copy ustack
-  for(int i = 1, j = 0; i < NPROC && j < NPROC;) {
-    if (j == curproc->rectidx) {
-      j++;
-      continue;
+  // 다른 thread들의 user stack도 복사되었으므로, child의 thread_create가
+  // 재사용할 수 있도록 freethreads에 넣어둔다.
+  nt->ustack = curthread->ustack;
+  nt->stackpages = curthread->stackpages;
+  nt->tls = curthread->tls;
+  nt->tlspages = curthread->tlspages;
+  for(i = 0; i < 2; i++){
+    for(t = i ? curproc->freethreads : curproc->threads; t; t = t->next){
+      if(t == curthread || t->ustack == 0)
+        continue;
+      if((ft = slaballoc(&threadcache)) == 0)
+        break;
+      memset(ft, 0, sizeof(*ft));
+      ft->proc = np;
+      ft->ustack = t->ustack;
+      ft->stackpages = t->stackpages;
+      ft->tls = t->tls;
+      ft->tlspages = t->tlspages;
+      ft->next = np->freethreads;
+      np->freethreads = ft;
     }
-    np->_ustack[i] = curproc->_ustack[j];
-    i++;
-    j++;
   }
-  np->_ustack[0] = curproc->_ustack[curproc->rectidx];
 
   np->state = RUNNABLE;
-  nt->state = RUNNABLE;
+  setrunnable(nt);
 
   release(&ptable.lock);
 
@@ -341,6 +633,17 @@ exit(void)
   if(curproc == initproc)
     panic("init exiting");
 
+  // Another thread has exited the process and left this one
+  // running (see below); wait() reaps it once none is.
+  acquire(&ptable.lock);
+  if(curproc->state == ZOMBIE){
+    mythread()->state = ZOMBIE;
+    wakeup1(curproc->parent);
+    sched();
+    panic("zombie exit");
+  }
+  release(&ptable.lock);
+
   // Close all open files.
   for(fd = 0; fd < NOFILE; fd++){
     if(curproc->ofile[fd]){
@@ -351,8 +654,12 @@ exit(void)
 
   begin_op();
   iput(curproc->cwd);
+  if(curproc->exe)
+    iput(curproc->exe);
   end_op();
   curproc->cwd = 0;
+  curproc->exe = 0;
+  curproc->nseg = 0;
 
   acquire(&ptable.lock);
 
@@ -370,11 +677,17 @@ exit(void)
 
   // Jump into the scheduler, never to return.
   curproc->state = ZOMBIE;
+  curproc->killed = 1;
 
-  for(t = curproc->ttable; t < &curproc->ttable[NPROC]; t++){
-    if (t->state != UNUSED) {
-      t->state = ZOMBIE;
-    }
+  for(t = curproc->threads; t; t = t->next){
+    // A thread running on another cpu still uses its kernel stack
+    // and the page table. It goes on until it sees killed and
+    // calls exit() itself.
+    if(t != mythread() && t->state == RUNNING)
+      continue;
+    unsleep(t);
+    unqueue(t);
+    t->state = ZOMBIE;
   }
 
   sched();
@@ -387,9 +700,9 @@ int
 wait(void)
 {
   struct proc *p;
+  struct thread *t;
   int havekids, pid;
   struct proc *curproc = myproc();
-  struct thread *t;
   
   acquire(&ptable.lock);
   for(;;){
@@ -400,15 +713,14 @@ wait(void)
         continue;
       havekids = 1;
       if(p->state == ZOMBIE){
+        // exit()이 남겨둔 thread가 아직 실행 중이면 기다린다.
+        for(t = p->threads; t && t->state == ZOMBIE; t = t->next)
+          ;
+        if(t)
+          continue;
         // wait하면서 thread를 정리해준다.
-        for(t = p->ttable; t < &p->ttable[NPROC]; t++){
-          if (t->state == UNUSED) continue;
-          p->_ustack[t-p->ttable] = 0;
-          kfree(t->kstack);
-          t->kstack = 0;
-          t->state = UNUSED;
-          t->tid = 0;
-        }
+        freethreads(p->threads);
+        freethreads(p->freethreads);
         // Found one.
         pid = p->pid;
         freevm(p->pgdir);
@@ -417,11 +729,13 @@ wait(void)
         p->name[0] = 0;
         p->killed = 0;
         p->state = UNUSED;
-        p->rectidx = 0;
-        p->mainidx = 0;
-        p->nextidx = 0;
+        p->threads = 0;
+        p->freethreads = 0;
+        p->main = 0;
+        p->nthread = 0;
         p->ssize = 0;
         p->memlim = 0;
+        p->rss = 0;
         release(&ptable.lock);
         return pid;
       }
@@ -449,46 +763,34 @@ wait(void)
 void
 scheduler(void)
 {
-  struct proc *p;
-  struct thread *t = 0;
+  struct thread *t;
   struct cpu *c = mycpu();
   c->proc = 0;
+  c->thread = 0;
   
   for(;;){
     // Enable interrupts on this processor.
     sti();
-    // Loop over process table looking for process to run.
+    // Run the thread at the head of the run queue, if any.
     acquire(&ptable.lock);
-    for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
-      if(p->state != RUNNABLE)
-        continue;
-      t = &p->ttable[p->nextidx];
-      for(int i = 0; i < NPROC; i++, t++){
-        if (t == &p->ttable[NPROC]) 
-          t = p->ttable;
-        if (t->state == RUNNABLE) 
-          break;
-      }
-      if (t->state != RUNNABLE)
-        continue;
-      // Switch to chosen process.  It is the process's job
+    if((t = ptable.runhead) != 0){
+      unqueue(t);
+      // Switch to chosen thread.  It is the thread's job
       // to release ptable.lock and then reacquire it
       // before jumping back to us.
-      c->proc = p;
-      p->rectidx = t - p->ttable;
-      p->nextidx = p->rectidx + 1;
-      if (p->nextidx == NPROC) p->nextidx = 0;
-      switchuvm(p);
+      c->proc = t->proc;
+      c->thread = t;
+      switchuvm(t->proc);
 
       t->state = RUNNING;
 
       swtch(&(c->scheduler), t->context);
       switchkvm();
 
-      // Process is done running for now.
-      // It should have changed its p->state before coming back.
+      // Thread is done running for now.
+      // It should have changed its t->state before coming back.
       c->proc = 0;
-      t = 0;
+      c->thread = 0;
     }
     release(&ptable.lock);
 
@@ -506,18 +808,18 @@ void
 sched(void)
 {
   int intena;
-  struct proc *p = myproc();
+  struct thread *t = mythread();
 
   if(!holding(&ptable.lock))
     panic("sched ptable.lock");
   if(mycpu()->ncli != 1)
     panic("sched locks");
-  if(mythread(p)->state == RUNNING)
+  if(t->state == RUNNING)
     panic("sched running");
   if(readeflags()&FL_IF)
     panic("sched interruptible");
   intena = mycpu()->intena;
-  swtch(&mythread(p)->context, mycpu()->scheduler);
+  swtch(&t->context, mycpu()->scheduler);
   mycpu()->intena = intena;
 }
 
@@ -526,8 +828,11 @@ void
 yield(void)
 {
   acquire(&ptable.lock);  //DOC: yieldlock
-  myproc()->state = RUNNABLE;
-  mythread(myproc())->state = RUNNABLE;
+  // A process that another thread has exited stays ZOMBIE; this
+  // thread runs on until it exits too.
+  if(myproc()->state != ZOMBIE)
+    myproc()->state = RUNNABLE;
+  setrunnable(mythread());
   sched();
   release(&ptable.lock);
 }
@@ -548,6 +853,7 @@ forkret(void)
     first = 0;
     iinit(ROOTDEV);
     initlog(ROOTDEV);
+    swapinit(ROOTDEV);
   }
 
   // Return to "caller", actually trapret (see allocproc).
@@ -578,8 +884,10 @@ sleep(void *chan, struct spinlock *lk)
     release(lk);
   }
   // Go to sleep.
-  t = mythread(p);
+  t = mythread();
   t->chan = chan;
+  t->sleepnext = *sleepq_of(chan);
+  *sleepq_of(chan) = t;
   t->state = SLEEPING;
   sched();
 
@@ -594,19 +902,53 @@ sleep(void *chan, struct spinlock *lk)
 }
 
 //PAGEBREAK!
+// Wake up at most n threads sleeping on chan, all if n < 0.
+// Returns the number woken.
+// The ptable lock must be held.
+static int
+wakeupn(void *chan, int n)
+{
+  struct thread **pp, *t;
+  int k = 0;
+
+  // Every thread in the bucket is SLEEPING.
+  for(pp = sleepq_of(chan); (t = *pp) != 0 && k != n; ){
+    if(t->chan != chan){
+      pp = &t->sleepnext;
+      continue;
+    }
+    *pp = t->sleepnext;
+    t->sleepnext = 0;
+    setrunnable(t);
+    k++;
+  }
+  return k;
+}
+
 // Wake up all processes sleeping on chan.
 // The ptable lock must be held.
 static void
 wakeup1(void *chan)
 {
-  struct proc *p;
-  struct thread *t;
+  wakeupn(chan, -1);
+}
 
-  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++)
-    if (p->state == RUNNABLE || p->state == SLEEPING)
-      for(t = p->ttable; t < &p->ttable[NPROC]; t++)
-        if(t->state == SLEEPING && t->chan == chan)
-          t->state = RUNNABLE;
+// Take a SLEEPING thread out of its wait-channel bucket
+// before its state is changed other than by wakeup1.
+// The ptable lock must be held.
+static void
+unsleep(struct thread *t)
+{
+  struct thread **pp;
+
+  if(t->state != SLEEPING)
+    return;
+  for(pp = sleepq_of(t->chan); *pp != 0; pp = &(*pp)->sleepnext)
+    if(*pp == t){
+      *pp = t->sleepnext;
+      t->sleepnext = 0;
+      return;
+    }
 }
 
 // Wake up all processes sleeping on chan.
@@ -633,9 +975,11 @@ kill(int pid)
       // Wake process from sleep if necessary.
       if(p->state == SLEEPING)
         p->state = RUNNABLE;
-      for(struct thread *t = p->ttable; t < &p->ttable[NPROC]; t++) {
-        if (t->state == SLEEPING) 
-          t->state = RUNNABLE;
+      for(struct thread *t = p->threads; t; t = t->next) {
+        if (t->state == SLEEPING) {
+          unsleep(t);
+          setrunnable(t);
+        }
       }
       release(&ptable.lock);
       return 0;
@@ -674,7 +1018,7 @@ procdump(void)
       state = "???";
     cprintf("%d %s %s", p->pid, state, p->name);
     if(p->state == SLEEPING){
-      getcallerpcs((uint*)mythread(p)->context->ebp+2, pc);
+      getcallerpcs((uint*)p->main->context->ebp+2, pc);
       for(i=0; i<10 && pc[i] != 0; i++)
         cprintf(" %p", pc[i]);
     }
@@ -685,111 +1029,167 @@ procdump(void)
 // LWP - Light weight process
 // thread create, exit, join system call
 
+// Choose between copy-on-write (on != 0) and eager fork.
+// Returns the previous setting.
+int
+setcowfork(int on)
+{
+  int old = cowfork;
+
+  cowfork = on != 0;
+  return old;
+}
+
+// Pick a user page for swapout() (see swap.c) with the clock
+// algorithm and move its mapping to swap slot slot; returns the
+// page, or 0 if none could be taken.
+// A process is skipped while one of its threads is running on
+// another cpu, which may hold TLB entries for its pages (there
+// is no TLB shootdown), or is in a system call, which may be
+// using its memory.
+char*
+swapvictim(uint slot)
+{
+  static struct proc *hand = ptable.proc;
+  static uint va;
+  struct proc *p;
+  struct thread *t, *cur;
+  char *v = 0;
+  int i;
+
+  cur = mythread();
+  acquire(&ptable.lock);
+  // Twice round: the first visit may only clear accessed bits.
+  for(i = 0; i < 2 * NPROC + 1 && v == 0; i++){
+    p = hand;
+    if(p->state != UNUSED && p->state != EMBRYO && p->state != ZOMBIE){
+      for(t = p->threads; t; t = t->next){
+        if(t->state == ZOMBIE)
+          continue;
+        if((t->state == RUNNING && t != cur) || t->insyscall)
+          break;
+      }
+      if(t == 0)
+        v = uvmevict(p, &va, slot);
+    }
+    if(v == 0){
+      va = 0;
+      if(++hand == &ptable.proc[NPROC])
+        hand = ptable.proc;
+    }
+  }
+  release(&ptable.lock);
+  return v;
+}
+
 // Thread create
 // 현재 프로세스에 start_routine의 instruction으로 새로운 thread를 만드는 함수
+// attr이 0이면 stack 1 page (guard page 별도), TLS 없음.
 int 
-thread_create(thread_t * thread, void *(*start_routine)(void *), void *arg)
+thread_create(thread_t * thread, void *(*start_routine)(void *), void *arg,
+              struct thread_attr *attr)
 {
   // allocproc, fork, exec
   struct thread *t;
   struct proc *curproc = myproc();
-  struct thread *curthread = mythread(curproc);
-  uint sz;
-  char *sp;
+  struct thread *curthread = mythread();
+  uint sz, sp, ustack[2];
+  int npages, ntls, n;
+
+  // stack(guard page 포함)과 TLS의 page 수
+  npages = 2;
+  ntls = 0;
+  if (attr) {
+    if (attr->stacksize >= KERNBASE || attr->tlssize >= KERNBASE)
+      return -1;
+    if (attr->stacksize)
+      npages = 1 + PGROUNDUP(attr->stacksize) / PGSIZE;
+    ntls = PGROUNDUP(attr->tlssize) / PGSIZE;
+  }
 
-// allocproc과 같이 process의 thread array에서 UNUSED인 공간을 찾는다.
+  // allocproc과 같이 thread를 할당받는다. kernel stack, trapret과
+  // forkret까지 allocthread에서 설정된다.
   acquire(&ptable.lock);
 
-  for(t = curproc->ttable; t < &curproc->ttable[NPROC]; t++)
-    if(t->state == UNUSED)
-      goto found;
-
-  release(&ptable.lock);
-  return -1;
-
-// UNUSED 공간 찾았을 경우
-found:
-  t->tid = nexttid++;
-  t->state = EMBRYO;
-
-  // Allocate kernel stack.
-  if((t->kstack = kalloc()) == 0)
-    goto bad;
-  
-  // stack pointer를 우선 설정한다.
-  sp = t->kstack + KSTACKSIZE;
-
-  // stack pointer를 내리면서 작동에 필요한 구성요소들을 넣는다.
-  // Leave room for trap frame.
-  sp -= sizeof *curthread->tf;
-  t->tf = (struct trapframe*)sp;
+  if((t = allocthread(curproc, npages, ntls)) == 0){
+    release(&ptable.lock);
+    return -1;
+  }
   *t->tf = *curthread->tf;
 
-  // trapret과 forkret을 넣는다.
-  // Set up new context to start executing at forkret,
-  // which returns to trapret.
-  sp -= 4;
-  *(uint*)sp = (uint)trapret;
-
-  // context 설정 부분
-  sp -= sizeof *t->context;
-  t->context = (struct context*)sp;
-  memset(t->context, 0, sizeof *t->context);
-  t->context->eip = (uint)forkret;
-
   // from exec
-  // 기존에 할당 받은 user stack이 아닌경우 user stack을 할당받고 설정한다.
-  if (curproc->_ustack[t - curproc->ttable] == 0) {
+  // 재사용할 user stack이 없는 경우 guard page, stack, TLS 순으로
+  // 할당받고 설정한다.
+  if (t->ustack == 0) {
     sz = PGROUNDUP(curproc->sz);
+    n = npages + ntls;
 
-    if (curproc->memlim != 0 && curproc->memlim < sz + 2 * PGSIZE)
+    if (curproc->memlim != 0 && curproc->memlim < (curproc->rss + n) * PGSIZE)
+      goto bad;
+    // heap 위에 n page가 KERNBASE 밑으로 들어가야 한다. 넘치면
+    // 주소가 wrap되어 allocuvm이 0이 아닌 oldsz를 돌려준다.
+    if (sz > KERNBASE || n > (KERNBASE - sz) / PGSIZE)
       goto bad;
 
-    if ((sz = allocuvm(curproc->pgdir, sz, sz + 2 * PGSIZE)) == 0)
+    if (allocuvm(curproc->pgdir, sz, sz + n * PGSIZE) != sz + n * PGSIZE)
       goto bad;
-    clearpteu(curproc->pgdir, (char*)(sz - 2*PGSIZE));
-    curproc->_ustack[t - curproc->ttable] = sz;
+    sz += n * PGSIZE;
+    clearpteu(curproc->pgdir, (char*)(sz - n*PGSIZE));
+    t->ustack = sz - ntls * PGSIZE;
+    t->stackpages = npages;
+    t->tls = ntls ? t->ustack : 0;
+    t->tlspages = ntls;
     curproc->sz = sz;
+    curproc->rss += n;
 
-    // stack용 페이지 수를 2개 늘린다.
-    curproc->ssize = curproc->ssize + 2;
+    // stack용 페이지 수를 늘린다.
+    curproc->ssize = curproc->ssize + npages;
   }
 
-  // thread의 argument와 fake pc값을 넣어준다.
-  sp = (char *)curproc->_ustack[t - curproc->ttable];
-  sp -= 4;
-  *(uint*)sp = (uint) arg;
-  sp -= 4;
-  *(uint*)sp = (uint) 0xffffffff;
-
   // Commit to the user image.
   // trap frame의 instruction pointer와 stack pointer를 설정해준다.
+  sp = t->ustack - sizeof(ustack);
   t->tf->eip = (uint)start_routine;  // thread가 작동할 함수의 주소값
-  t->tf->esp = (uint)sp;
+  t->tf->esp = sp;
+  t->tf->gs = ntls ? (SEG_UTLS << 3) | DPL_USER : 0;
+  release(&ptable.lock);
 
-  // 생성된 thread의 state를 RUNNABLE로 만들어준다.
-  t->state = RUNNABLE;
+  // thread의 argument와 fake pc값을 넣어주고 TLS를 초기화한다.
+  // 재사용하는 stack은 swap되어 있거나 copy-on-write일 수 있으므로
+  // ptable.lock 없이 copyout으로 쓴다.
+  ustack[0] = 0xffffffff;
+  ustack[1] = (uint)arg;
+  if (uvmtouch(sp, sizeof(ustack)) < 0 ||
+      copyout(curproc->pgdir, sp, ustack, sizeof(ustack)) < 0)
+    goto badtouch;
+  if (ntls) {
+    if (uvmtouch(t->tls, t->tlspages * PGSIZE) < 0 ||
+        uvmclear(curproc->pgdir, t->tls, t->tlspages * PGSIZE) < 0 ||
+        copyout(curproc->pgdir, t->tls, &t->tls, sizeof(t->tls)) < 0)
+      goto badtouch;
+  }
+
+  // 생성된 thread의 state를 RUNNABLE로 만들고 run queue에 넣어준다.
+  acquire(&ptable.lock);
+  if (t->state == EMBRYO)
+    setrunnable(t);
 
   // thread 인자에 새로 생긴 thread의 tid(thread id)를 넣어준다.
   *thread = t->tid;
   release(&ptable.lock);
   return 0;
 
+badtouch:
+  acquire(&ptable.lock);
 bad:
-  if (t->kstack) {
-    kfree(t->kstack);
-  }
-  t->kstack = 0;
-  t->tid = 0;
-  t->state = UNUSED;
+  putthread(t);
   release(&ptable.lock);
   return -1;
 }
 
 void
 thread_exit(void *retval){
-  struct proc *p = myproc();
-  struct thread *t = mythread(p);
+  struct thread *t = mythread();
 
   acquire(&ptable.lock);
 
@@ -816,20 +1216,19 @@ thread_join(thread_t thread, void **retval) {
   for(;;){
     // Scan through table looking for exited children.
     havekids = 0;
-    for(t = curproc->ttable; t < &curproc->ttable[NPROC]; t++){
+    for(t = curproc->threads; t; t = t->next){
       if(t->tid != thread)
         continue;
       havekids = 1;
       if(t->state == ZOMBIE){
         if (retval != 0)
           *retval = t->retval;
-        kfree(t->kstack);
-        t->kstack = 0;
-        t->state = UNUSED;
-        t->tid = 0;
+        // user stack은 다음 thread_create를 위해 남겨둔다.
+        putthread(t);
         release(&ptable.lock);
         return 0;
       }
+      break;
     }
 
     // No point waiting if we don't have any children.
@@ -842,4 +1241,91 @@ thread_join(thread_t thread, void **retval) {
     // Wait for children to exit.  (See wakeup1 call in proc_exit.)
     sleep((void *)thread, &ptable.lock);  //DOC: wait-sleep
   }
-}
\ No newline at end of file
+}
+
+// Give p the new image pgdir of size sz, for exec, and return
+// the old page table for the caller to free. Under ptable.lock,
+// so that getprocstat() and swapvictim(), which walk the page
+// tables of other processes, never pair the new size with the old
+// page table or walk one that is being freed.
+pde_t*
+commituvm(struct proc *p, pde_t *pgdir, uint sz)
+{
+  pde_t *old;
+
+  acquire(&ptable.lock);
+  old = p->pgdir;
+  p->pgdir = pgdir;
+  p->sz = sz;
+  p->rss = uvmresident(pgdir, 0, sz);
+  release(&ptable.lock);
+  return old;
+}
+
+// Release every thread of p except the main thread.
+// exec calls this once the new image is committed.
+void
+clearthreads(struct proc *p)
+{
+  struct thread *t, *next;
+
+  acquire(&ptable.lock);
+  for(t = p->threads; t; t = next){
+    next = t->next;
+    if (t == p->main) continue;
+    unsleep(t);
+    unqueue(t);
+    unlinkthread(t);
+    freethreads(t);
+  }
+  freethreads(p->freethreads);
+  p->freethreads = 0;
+  release(&ptable.lock);
+}
+
+// Futexes
+// A futex is a user word that threads sleep on until another
+// thread changes it and wakes them. It is keyed by its physical
+// address, through the kernel mapping of its page, which serves as
+// the wait channel. uvmfutex() keeps the page from moving while
+// threads wait on it: it breaks copy-on-write sharing first and
+// marks the page so that fork copies it for the child instead of
+// sharing it. The page cannot be swapped out either, because the
+// waiters are still in a system call.
+
+// Sleep on the word at user address va if it still holds val.
+// Returns 0 when woken, or -1 if the word changed or va is bad.
+int
+futexwait(uint va, uint val)
+{
+  uint *w;
+
+  acquire(&ptable.lock);
+  // Nobody would wake us once the process has been killed.
+  if(myproc()->killed ||
+     (w = uvmfutex(myproc()->pgdir, va)) == 0 || *w != val){
+    release(&ptable.lock);
+    return -1;
+  }
+  sleep(w, &ptable.lock);
+  release(&ptable.lock);
+  return 0;
+}
+
+// Wake at most n threads waiting on the word at user address va.
+// Returns the number woken, or -1 if va is bad.
+int
+futexwake(uint va, int n)
+{
+  uint *w;
+  int k;
+
+  acquire(&ptable.lock);
+  if((w = uvmfutex(myproc()->pgdir, va)) == 0){
+    release(&ptable.lock);
+    return -1;
+  }
+  k = wakeupn(w, n);
+  release(&ptable.lock);
+  return k;
+}
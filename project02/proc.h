@@ -8,6 +8,9 @@ struct cpu {
   int ncli;                    // Depth of pushcli nesting.
   int intena;                  // Were interrupts enabled before pushcli?
   struct proc *proc;           // The process running on this cpu or null
+  struct thread *thread;       // ... and its thread
+  pde_t *pgdir;                // Page table loaded, or 0 for kpgdir
+  volatile uint tlbflush;      // Asked to flush by tlbshootdown()
 };
 
 extern struct cpu cpus[NCPU];
@@ -34,6 +37,14 @@ struct context {
 
 enum procstate { UNUSED, EMBRYO, SLEEPING, RUNNABLE, RUNNING, ZOMBIE };
 
+// Page faults resolved by pagefault() in vm.c, by kind.
+struct faultcount {
+  uint cow;                    // Copy-on-write
+  uint lazy;                   // Heap page allocated on first touch
+  uint exec;                   // Program page mapped on first touch
+  uint swapin;                 // Page read back from swap
+};
+
 
 // Thread
 struct thread {
@@ -42,9 +53,32 @@ struct thread {
   struct trapframe *tf;        // Trap frame for current syscall
   struct context *context;     // swtch() here to run process
   void *chan;                  // If non-zero, sleeping on chan
+  struct thread *sleepnext;    // Next sleeper in the same wait-channel bucket
+  struct thread *runnext;      // Run queue links, while RUNNABLE
+  struct thread *runprev;
 
   thread_t tid;                // Thread id
   void *retval;                // return value of thread
+  int insyscall;               // In a system call, which may use its user memory
+  struct faultcount faults;    // Faults taken by this thread
+
+  struct proc *proc;           // Process it belongs to
+  struct thread *next;         // Next thread of the process
+  struct thread *prev;
+  uint ustack;                 // Top of its user stack, 0 if none yet
+  int stackpages;              // ... pages below it, the guard page included
+  uint tls;                    // Thread-local storage (%gs base), 0 if none
+  int tlspages;
+};
+
+// A program segment that exec leaves to be read from the
+// executable on first touch (see pagefault in vm.c).
+#define NEXECSEG 4
+
+struct execseg {
+  uint vaddr;                  // Page aligned
+  uint filesz;                 // Bytes from the file; the rest is zero
+  uint off;                    // Offset in the file
 };
 
 // Per-process state
@@ -62,14 +96,22 @@ struct proc {
 
   // Added
   int memlim;                  // If zero, memory size is unlimit.
+                               // Checked against rss, not sz.
+  int rss;                     // User pages mapped or swapped out (heap pages only once touched)
+  struct inode *exe;           // Executable the segments are read from
+  struct execseg seg[NEXECSEG];
+  int nseg;
   int ssize;                   // Stack용 페이지 갯수
+  struct faultcount faults;    // Faults taken by all its threads, gone ones included
 
   // Thread
-  int rectidx;                // 가장 최근에 접근했던 thread의 index (for scheduler)
-  int mainidx;                // main thread의 index
-  int nextidx;                // 다음에 스케줄될 thread의 index
-  struct thread ttable[NPROC];     // thread list
-  uint _ustack[NPROC];             // user stack for thread
+  // Threads are allocated from a slab cache when created. A joined
+  // thread moves to freethreads with its user stack, which the
+  // next thread_create() reuses.
+  struct thread *threads;      // thread list (not joined yet)
+  struct thread *freethreads;  // joined threads, linked by next
+  struct thread *main;         // main thread
+  int nthread;                 // threads 개수
 };
 
 // Process memory is laid out contiguously, low addresses first:
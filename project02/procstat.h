@@ -0,0 +1,33 @@
+// Memory and page fault statistics of a process, reported by
+// getprocstat(), and of its threads, by getthreadstat().
+// Memory is counted in pages. The fault counters wrap; take
+// differences.
+struct procstat {
+  int pid;
+  char name[16];
+  int state;       // Of the main thread, as enum procstate in proc.h
+  uint sz;         // Size of the address space (bytes)
+  int memlim;      // Memory limit (bytes), 0 if none
+  int rss;         // Pages counted against memlim: mapped or in swap
+  int resident;    // User pages mapped
+  int shared;      // ... that another process or the page cache also maps
+  int swapped;     // User pages in swap
+  int ptpages;     // Page-table pages, the page directory included
+  int ssize;       // Stack pages of all threads
+  int nthread;     // Threads not yet joined
+  uint cow;        // Copy-on-write faults, by all threads
+  uint lazy;       // Heap pages allocated on first touch
+  uint exec;       // Program pages mapped on first touch
+  uint swapin;     // Pages read back from swap
+};
+
+struct threadstat {
+  int tid;
+  int state;       // As enum procstate in proc.h
+  uint stack;      // Top of its user stack
+  int ssize;       // Stack pages
+  uint cow;        // Faults taken by this thread, as in procstat
+  uint lazy;
+  uint exec;
+  uint swapin;
+};
@@ -0,0 +1,64 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+// Parallel CPU-bound benchmark.
+// usage: sched_bench [maxthreads]
+// Splits a fixed amount of arithmetic among n threads of one
+// process and prints the time and the speedup over one thread.
+// Runnable threads are scheduled from one run queue, so with
+// CPUS=4 the time should drop until n reaches the number of cpus.
+
+#define WORK (1 << 28)
+#define MAXTHREAD 16
+
+thread_t tids[MAXTHREAD];
+volatile uint sinks[MAXTHREAD];
+int nthread;
+
+void*
+worker(void *arg)
+{
+  int id = (int)arg;
+  uint i, x = id;
+
+  for(i = 0; i < WORK / nthread; i++)
+    x = x * 1103515245 + 12345;
+  sinks[id] = x;
+  thread_exit(0);
+  return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int max, i, start, ticks, base;
+  void *ret;
+
+  max = 8;
+  if(argc > 1)
+    max = atoi(argv[1]);
+  if(max < 1 || max > MAXTHREAD)
+    max = MAXTHREAD;
+
+  printf(1, "threads  ticks  speedup x100\n");
+  base = 0;
+  for(nthread = 1; nthread <= max; nthread *= 2){
+    start = uptime();
+    for(i = 0; i < nthread; i++){
+      if(thread_create(&tids[i], worker, (void*)i) != 0){
+        printf(1, "thread_create failed\n");
+        exit();
+      }
+    }
+    for(i = 0; i < nthread; i++)
+      thread_join(tids[i], &ret);
+    ticks = uptime() - start;
+    if(ticks == 0)
+      ticks = 1;
+    if(nthread == 1)
+      base = ticks;
+    printf(1, "%d  %d  %d\n", nthread, ticks, base * 100 / ticks);
+  }
+  exit();
+}
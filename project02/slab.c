@@ -0,0 +1,172 @@
+// Slab allocator for fixed-size kernel objects.
+//
+// Each cache carves whole pages from kalloc() into objects of one
+// size. A page (a slab) starts with a struct slab header and
+// keeps its free objects on a list; the link of a free object
+// lives right after it, so the state left by the constructor is
+// kept while an object is free and ctor runs only once per object.
+//
+// slaballoc() and slabfree() work on a per-cpu array of objects
+// with interrupts off, and take the cache lock only to move
+// SLAB_MAG/2 objects at once between it and the slabs.
+// A slab whose objects are all free goes back to kalloc() unless
+// it is the only slab with free objects.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "mmu.h"
+#include "spinlock.h"
+#include "slab.h"
+
+#define SLAB_BATCH (SLAB_MAG / 2)
+#define SLAB_LINK(c, o) (*(void**)((char*)(o) + (c)->size))
+
+struct slab {
+  struct slabcache *cache;
+  struct slab *next;           // on cache->partial
+  struct slab *prev;
+  void *free;                  // Free objects
+  int inuse;
+};
+
+void
+slabinit(struct slabcache *c, char *name, uint size, void (*ctor)(void*))
+{
+  memset(c, 0, sizeof(*c));
+  initlock(&c->lock, name);
+  c->name = name;
+  c->size = (size + 3) & ~3;
+  c->objsize = c->size + sizeof(void*);
+  c->perslab = (PGSIZE - sizeof(struct slab)) / c->objsize;
+  if(c->perslab < 1)
+    panic("slabinit");
+  c->ctor = ctor;
+}
+
+// Caller must hold c->lock for the helpers below.
+static void
+slablink(struct slabcache *c, struct slab *s)
+{
+  s->prev = 0;
+  s->next = c->partial;
+  if(c->partial)
+    c->partial->prev = s;
+  c->partial = s;
+}
+
+static void
+slabunlink(struct slabcache *c, struct slab *s)
+{
+  if(s->prev)
+    s->prev->next = s->next;
+  else
+    c->partial = s->next;
+  if(s->next)
+    s->next->prev = s->prev;
+}
+
+// Carve a new page into constructed objects.
+static struct slab*
+slabgrow(struct slabcache *c)
+{
+  struct slab *s;
+  char *o;
+  int i;
+
+  if((s = (struct slab*)kalloc()) == 0)
+    return 0;
+  s->cache = c;
+  s->free = 0;
+  s->inuse = 0;
+  o = (char*)(s + 1);
+  for(i = 0; i < c->perslab; i++, o += c->objsize){
+    if(c->ctor)
+      c->ctor(o);
+    SLAB_LINK(c, o) = s->free;
+    s->free = o;
+  }
+  slablink(c, s);
+  c->nslab++;
+  return s;
+}
+
+static void*
+slabget(struct slabcache *c)
+{
+  struct slab *s;
+  void *o;
+
+  if((s = c->partial) == 0 && (s = slabgrow(c)) == 0)
+    return 0;
+  o = s->free;
+  s->free = SLAB_LINK(c, o);
+  s->inuse++;
+  c->inuse++;
+  if(s->free == 0)
+    slabunlink(c, s);
+  return o;
+}
+
+static void
+slabput(struct slabcache *c, void *o)
+{
+  struct slab *s = (struct slab*)PGROUNDDOWN((uint)o);
+
+  if(s->cache != c)
+    panic("slabfree");
+  if(s->free == 0)
+    slablink(c, s);
+  SLAB_LINK(c, o) = s->free;
+  s->free = o;
+  s->inuse--;
+  c->inuse--;
+  if(s->inuse == 0 && (c->partial != s || s->next != 0)){
+    slabunlink(c, s);
+    c->nslab--;
+    kfree((char*)s);
+  }
+}
+
+// Allocate an object, in the state its constructor left it
+// (or the last user, who must restore that state before freeing).
+// Returns 0 if out of memory.
+void*
+slaballoc(struct slabcache *c)
+{
+  void *o;
+  int *n, cpu;
+
+  pushcli();
+  cpu = cpuid();
+  n = &c->cpu[cpu].n;
+  if(*n == 0){
+    acquire(&c->lock);
+    while(*n < SLAB_BATCH && (o = slabget(c)) != 0)
+      c->cpu[cpu].obj[(*n)++] = o;
+    release(&c->lock);
+  }
+  o = 0;
+  if(*n > 0)
+    o = c->cpu[cpu].obj[--(*n)];
+  popcli();
+  return o;
+}
+
+void
+slabfree(struct slabcache *c, void *o)
+{
+  int *n, cpu;
+
+  pushcli();
+  cpu = cpuid();
+  n = &c->cpu[cpu].n;
+  if(*n == SLAB_MAG){
+    acquire(&c->lock);
+    while(*n > SLAB_BATCH)
+      slabput(c, c->cpu[cpu].obj[--(*n)]);
+    release(&c->lock);
+  }
+  c->cpu[cpu].obj[(*n)++] = o;
+  popcli();
+}
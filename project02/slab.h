@@ -0,0 +1,20 @@
+// Object cache for fixed-size kernel objects (see slab.c).
+#define SLAB_MAG 16            // Objects cached per cpu
+
+struct slab;
+
+struct slabcache {
+  struct spinlock lock;        // protects the slabs and counters
+  char *name;
+  uint size;                   // Object size, rounded up to 4 bytes
+  uint objsize;                // ... plus the free-list link
+  int perslab;                 // Objects in a page
+  void (*ctor)(void*);         // Run once on each new object
+  struct slab *partial;        // Slabs with free objects
+  int nslab;                   // Pages in use
+  int inuse;                   // Objects handed out, cached ones included
+  struct {
+    void *obj[SLAB_MAG];
+    int n;
+  } cpu[NCPU];                 // Per-cpu object caches
+};
@@ -0,0 +1,163 @@
+// Swap space for user pages.
+//
+// mkfs leaves a swap area of sb.nswap page-sized slots after the
+// file system. When kalloc() runs dry, a caller that can sleep
+// (see ualloc in vm.c) calls swapout(), which picks a user page
+// with the clock algorithm (swapvictim in proc.c, uvmevict in
+// vm.c), writes it to a free slot and frees it. The PTE keeps the
+// slot number, with PTE_SWAP instead of PTE_P, and swapin() in
+// vm.c reads the page back on the next touch.
+//
+// fork shares swapped pages like resident ones, so slots have
+// reference counts. The lock of swap.buf serializes swap I/O: a
+// page is never read back before it has been written out.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "x86.h"
+#include "proc.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "fs.h"
+#include "buf.h"
+
+#define BPP (PGSIZE / BSIZE)   // Blocks per page
+
+static struct {
+  struct buf buf;       // Its lock serializes swap I/O
+  uint dev;
+  uint start;           // First block of the swap area
+  uint nslot;
+  uint next;            // Where to look for a free slot
+  uint nused;
+  uint ins;
+  uint outs;
+  ushort ref[NSWAP];    // References to each slot
+} swap;
+
+void
+swapinit(int dev)
+{
+  struct superblock sb;
+
+  initsleeplock(&swap.buf.lock, "swap");
+  readsb(dev, &sb);
+  swap.dev = dev;
+  swap.start = sb.swapstart;
+  swap.nslot = sb.nswap;
+  if(swap.nslot > NSWAP)
+    swap.nslot = NSWAP;
+}
+
+void
+swaplock(void)
+{
+  acquiresleep(&swap.buf.lock);
+}
+
+void
+swapunlock(void)
+{
+  releasesleep(&swap.buf.lock);
+}
+
+// Write page v to slot, or read it, through swap.buf.
+// Caller holds swap.buf.lock.
+static void
+swaprw(uint slot, char *v, int write)
+{
+  struct buf *b = &swap.buf;
+  int i;
+
+  b->dev = swap.dev;
+  for(i = 0; i < BPP; i++){
+    b->blockno = swap.start + slot * BPP + i;
+    if(write){
+      memmove(b->data, v + i * BSIZE, BSIZE);
+      b->flags = B_DIRTY;
+    } else
+      b->flags = 0;
+    iderw(b);
+    if(!write)
+      memmove(v + i * BSIZE, b->data, BSIZE);
+  }
+}
+
+// Read slot into page v. Caller holds swaplock().
+void
+swapread(uint slot, char *v)
+{
+  swaprw(slot, v, 0);
+  swap.ins++;
+}
+
+// Free a page by writing a user page out to swap.
+// Sleeps. Returns 0, or -1 if swap is full or no page
+// can be taken.
+int
+swapout(void)
+{
+  uint slot, n;
+  char *v;
+
+  acquiresleep(&swap.buf.lock);
+  slot = swap.next;
+  for(n = 0; n < swap.nslot; n++){
+    if(swap.ref[slot] == 0)
+      break;
+    if(++slot == swap.nslot)
+      slot = 0;
+  }
+  if(n == swap.nslot){
+    releasesleep(&swap.buf.lock);
+    return -1;
+  }
+  // Taken before the PTE points to it: the owner may free
+  // the slot as soon as swapvictim() returns.
+  swap.ref[slot] = 1;
+  __sync_fetch_and_add(&swap.nused, 1);
+  if((v = swapvictim(slot)) == 0){
+    swap.ref[slot] = 0;
+    __sync_fetch_and_sub(&swap.nused, 1);
+    releasesleep(&swap.buf.lock);
+    return -1;
+  }
+  swap.next = slot + 1 == swap.nslot ? 0 : slot + 1;
+  swaprw(slot, v, 1);
+  swap.outs++;
+  releasesleep(&swap.buf.lock);
+
+  // The page may have been ours; drop its TLB entry.
+  if(myproc())
+    lcr3(V2P(myproc()->pgdir));
+  kfree(v);
+  return 0;
+}
+
+// Another reference to slot, by fork.
+void
+swapdup(uint slot)
+{
+  __sync_fetch_and_add(&swap.ref[slot], 1);
+}
+
+// Drop a reference to slot.
+void
+swapfree(uint slot)
+{
+  if(swap.ref[slot] == 0)
+    panic("swapfree");
+  if(__sync_sub_and_fetch(&swap.ref[slot], 1) == 0)
+    __sync_fetch_and_sub(&swap.nused, 1);
+}
+
+void
+swapstat(uint *used, uint *ins, uint *outs)
+{
+  *used = swap.nused;
+  *ins = swap.ins;
+  *outs = swap.outs;
+}
@@ -0,0 +1,76 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "kmemstat.h"
+
+// Swap benchmark.
+// usage: swap_bench [MiB]
+// Reserves twice the free physical memory (or MiB) with sbrk,
+// writes a word to every page, then reads them all back twice,
+// checking them. For each pass prints the time, the throughput
+// and the pages moved to and from swap per second.
+
+uint
+freepages(void)
+{
+  struct kmemstat st;
+
+  getkmemstat(&st);
+  return st.nfree + st.ncached;
+}
+
+void
+report(char *pass, int npages, int t, struct kmemstat *before)
+{
+  struct kmemstat after;
+  int faults;
+
+  getkmemstat(&after);
+  faults = (after.swapins - before->swapins) + (after.swapouts - before->swapouts);
+  if(t == 0)
+    t = 1;
+  // A tick is 10ms.
+  printf(1, "%s: %d ticks, %d KiB/s, %d swap-ins %d swap-outs, %d per second\n",
+         pass, t, npages * 4 * 100 / t, after.swapins - before->swapins,
+         after.swapouts - before->swapouts, faults * 100 / t);
+  *before = after;
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct kmemstat st;
+  int npages, i, j, start;
+  char *p;
+
+  if(argc > 1)
+    npages = atoi(argv[1]) * 256;
+  else
+    npages = 2 * freepages();
+  printf(1, "%d pages (%d MiB), %d free\n", npages, npages / 256, freepages());
+
+  p = sbrk(npages * 4096);
+  if(p == (char*)-1){
+    printf(1, "sbrk failed\n");
+    exit();
+  }
+
+  getkmemstat(&st);
+  start = uptime();
+  for(i = 0; i < npages; i++)
+    *(int*)(p + i * 4096) = i;
+  report("write", npages, uptime() - start, &st);
+
+  for(j = 0; j < 2; j++){
+    start = uptime();
+    for(i = 0; i < npages; i++){
+      if(*(int*)(p + i * 4096) != i){
+        printf(1, "page %d lost its contents\n", i);
+        exit();
+      }
+    }
+    report("read", npages, uptime() - start, &st);
+  }
+  printf(1, "swap slots in use: %d\n", st.swapused);
+  exit();
+}
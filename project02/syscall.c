@@ -21,6 +21,8 @@ fetchint(uint addr, int *ip)
 
   if(addr >= curproc->sz || addr+4 > curproc->sz)
     return -1;
+  if(uvmtouch(addr, 4) < 0)
+    return -1;
   *ip = *(int*)(addr);
   return 0;
 }
@@ -39,6 +41,8 @@ fetchstr(uint addr, char **pp)
   *pp = (char*)addr;
   ep = (char*)curproc->sz;
   for(s = *pp; s < ep; s++){
+    if((s == *pp || (uint)s % PGSIZE == 0) && uvmtouch((uint)s, 1) < 0)
+      return -1;
     if(*s == 0)
       return s - *pp;
   }
@@ -49,7 +53,7 @@ fetchstr(uint addr, char **pp)
 int
 argint(int n, int *ip)
 {
-  return fetchint((mythread(myproc())->tf->esp) + 4 + 4*n, ip);
+  return fetchint((mythread()->tf->esp) + 4 + 4*n, ip);
 }
 
 // Fetch the nth word-sized system call argument as a pointer
@@ -65,6 +69,8 @@ argptr(int n, char **pp, int size)
     return -1;
   if(size < 0 || (uint)i >= curproc->sz || (uint)i+size > curproc->sz)
     return -1;
+  if(uvmtouch(i, size) < 0)
+    return -1;
   *pp = (char*)i;
   return 0;
 }
@@ -109,6 +115,13 @@ extern int sys_list(void);
 extern int sys_thread_create(void);
 extern int sys_thread_exit(void);
 extern int sys_thread_join(void);
+extern int sys_getkmemstat(void);
+extern int sys_setcowfork(void);
+extern int sys_getprocstat(void);
+extern int sys_getthreadstat(void);
+extern int sys_futex_wait(void);
+extern int sys_futex_wake(void);
+extern int sys_thread_create_attr(void);
 
 static int (*syscalls[])(void) = {
 [SYS_fork]    sys_fork,
@@ -138,6 +151,13 @@ static int (*syscalls[])(void) = {
 [SYS_thread_create]   sys_thread_create,
 [SYS_thread_exit]     sys_thread_exit,
 [SYS_thread_join]     sys_thread_join,
+[SYS_getkmemstat]     sys_getkmemstat,
+[SYS_setcowfork]      sys_setcowfork,
+[SYS_getprocstat]     sys_getprocstat,
+[SYS_getthreadstat]   sys_getthreadstat,
+[SYS_futex_wait]      sys_futex_wait,
+[SYS_futex_wake]      sys_futex_wake,
+[SYS_thread_create_attr] sys_thread_create_attr,
 };
 
 void
@@ -145,7 +165,7 @@ syscall(void)
 {
   int num;
   struct proc *curproc = myproc();
-  struct thread *curthread = mythread(curproc);
+  struct thread *curthread = mythread();
   num = curthread->tf->eax;
   if(num > 0 && num < NELEM(syscalls) && syscalls[num]) {
     curthread->tf->eax = syscalls[num]();
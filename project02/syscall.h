@@ -25,4 +25,11 @@
 #define SYS_list   24
 #define SYS_thread_create  25
 #define SYS_thread_exit    26
-#define SYS_thread_join    27
\ No newline at end of file
+#define SYS_thread_join    27
+#define SYS_getkmemstat    28
+#define SYS_setcowfork     29
+#define SYS_getprocstat    30
+#define SYS_getthreadstat  31
+#define SYS_futex_wait     32
+#define SYS_futex_wake     33
+#define SYS_thread_create_attr 34
\ No newline at end of file
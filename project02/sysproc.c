@@ -6,6 +6,9 @@
 #include "memlayout.h"
 #include "mmu.h"
 #include "proc.h"
+#include "kmemstat.h"
+#include "procstat.h"
+#include "threadattr.h"
 
 int
 sys_fork(void)
@@ -147,7 +150,23 @@ sys_thread_create(void)
     return -1;
   }
 
-  return thread_create(thread, start_routine, arg);
+  return thread_create(thread, start_routine, arg, 0);
+}
+
+int
+sys_thread_create_attr(void)
+{
+  thread_t* thread; 
+  void *(*start_routine)(void *); 
+  void *arg;
+  struct thread_attr *attr, a;
+
+  if(argptr(0, (char **)&thread, sizeof(thread)) < 0 || argint(1, (int *)&start_routine) < 0 || argint(2, (int *)&arg) < 0 || argptr(3, (char **)&attr, sizeof(*attr)) < 0) {
+    return -1;
+  }
+  a = *attr;
+
+  return thread_create(thread, start_routine, arg, &a);
 }
 
 int
@@ -174,4 +193,86 @@ sys_thread_join(void)
   }
 
   return thread_join(thread, retval);
-}
\ No newline at end of file
+}
+int
+sys_getkmemstat(void)
+{
+  struct kmemstat *st;
+
+  if(argptr(0, (char **)&st, sizeof(*st)) < 0){
+    return -1;
+  }
+
+  getkmemstat(st);
+  return 0;
+}
+
+int
+sys_setcowfork(void)
+{
+  int on;
+
+  if(argint(0, &on) < 0){
+    return -1;
+  }
+
+  return setcowfork(on);
+}
+
+int
+sys_getprocstat(void)
+{
+  struct procstat *ps;
+  int n;
+
+  if(argint(1, &n) < 0 || n < 0 || n > NPROC){
+    return -1;
+  }
+  if(argptr(0, (char **)&ps, n * sizeof(*ps)) < 0){
+    return -1;
+  }
+
+  return getprocstat(ps, n);
+}
+
+int
+sys_getthreadstat(void)
+{
+  struct threadstat *ts;
+  int pid, n;
+
+  if(argint(0, &pid) < 0 || argint(2, &n) < 0 || n < 0 || n > NTHREAD){
+    return -1;
+  }
+  if(argptr(1, (char **)&ts, n * sizeof(*ts)) < 0){
+    return -1;
+  }
+
+  return getthreadstat(pid, ts, n);
+}
+
+int
+sys_futex_wait(void)
+{
+  uint *addr;
+  int val;
+
+  if(argptr(0, (char **)&addr, sizeof(*addr)) < 0 || argint(1, &val) < 0){
+    return -1;
+  }
+
+  return futexwait((uint)addr, val);
+}
+
+int
+sys_futex_wake(void)
+{
+  uint *addr;
+  int n;
+
+  if(argptr(0, (char **)&addr, sizeof(*addr)) < 0 || argint(1, &n) < 0){
+    return -1;
+  }
+
+  return futexwake((uint)addr, n);
+}
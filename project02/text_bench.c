@@ -0,0 +1,70 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "kmemstat.h"
+
+// Shared program page benchmark.
+// usage: text_bench [instances]
+// Starts instances of cat that block reading a pipe, and prints
+// the pages each one takes and how many of its program pages
+// came from the page cache. The first instance reads its pages
+// from the file; the others should map the same pages.
+
+#define MAXINST 16
+
+uint
+freepages(void)
+{
+  struct kmemstat st;
+
+  getkmemstat(&st);
+  return st.nfree + st.ncached;
+}
+
+int
+main(int argc, char *argv[])
+{
+  char *args[] = {"cat", 0};
+  struct kmemstat before, after;
+  int fds[MAXINST][2];
+  uint free;
+  int n, i;
+
+  n = 4;
+  if(argc > 1)
+    n = atoi(argv[1]);
+  if(n < 1 || n > MAXINST)
+    n = MAXINST;
+
+  printf(1, "instance  pages  cache hits  misses\n");
+  for(i = 0; i < n; i++){
+    if(pipe(fds[i]) < 0){
+      printf(1, "pipe failed\n");
+      exit();
+    }
+    getkmemstat(&before);
+    free = freepages();
+    if(fork() == 0){
+      close(0);
+      dup(fds[i][0]);
+      close(fds[i][0]);
+      close(fds[i][1]);
+      exec(args[0], args);
+      printf(1, "exec failed\n");
+      exit();
+    }
+    close(fds[i][0]);
+    // Let the child run until it blocks in read.
+    sleep(10);
+    getkmemstat(&after);
+    printf(1, "%d  %d  %d  %d\n", i, free - freepages(),
+           after.pchits - before.pchits, after.pcmisses - before.pcmisses);
+  }
+  printf(1, "page cache: %d pages\n", after.pcpages);
+
+  for(i = 0; i < n; i++)
+    close(fds[i][1]);
+  while(wait() != -1)
+    ;
+  exit();
+}
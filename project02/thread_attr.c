@@ -0,0 +1,94 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "threadattr.h"
+
+// Thread attribute test.
+// Runs a deep recursion on a thread with a 64KB stack, then
+// checks that threads with thread-local storage each see their
+// own block through %gs, across sleeps and after their stacks
+// are reused.
+
+#define NUM_THREAD 4
+#define DEPTH 800
+
+struct tls {
+  struct tls *self;   // Set by the kernel
+  int id;
+  int count;
+};
+
+thread_t thread[NUM_THREAD];
+
+void failed(char *msg)
+{
+  printf(1, "Test failed: %s\n", msg);
+  exit();
+}
+
+// About 50 bytes of stack per call: far more than a one-page stack.
+int recurse(int n)
+{
+  volatile int pad[8];
+
+  pad[0] = n;
+  if (n == 0)
+    return 0;
+  return recurse(n - 1) + 1 + pad[0] - n;
+}
+
+void *thread_deep(void *arg)
+{
+  thread_exit((void*)recurse(DEPTH));
+  return 0;
+}
+
+void *thread_tls(void *arg)
+{
+  struct tls *t = tls_get();
+  int i;
+
+  if (t == 0 || t->self != t)
+    failed("no TLS self pointer");
+  if (t->id != 0 || t->count != 0)
+    failed("TLS not zeroed");
+  t->id = (int)arg;
+  for (i = 0; i < 10; i++) {
+    sleep(1);
+    t->count++;
+    if (((struct tls*)tls_get())->id != (int)arg)
+      failed("TLS of another thread");
+  }
+  thread_exit((void*)t->count);
+  return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct thread_attr attr;
+  void *ret;
+  int i, round;
+
+  attr.stacksize = 64 * 1024;
+  attr.tlssize = 0;
+  if (thread_create_attr(&thread[0], thread_deep, 0, &attr) != 0)
+    failed("thread_create_attr");
+  if (thread_join(thread[0], &ret) != 0 || (int)ret != DEPTH)
+    failed("deep recursion");
+  printf(1, "64KB stack ok\n");
+
+  attr.stacksize = 0;
+  attr.tlssize = sizeof(struct tls);
+  for (round = 0; round < 2; round++) {
+    for (i = 0; i < NUM_THREAD; i++)
+      if (thread_create_attr(&thread[i], thread_tls, (void*)(i + 1), &attr) != 0)
+        failed("thread_create_attr");
+    for (i = 0; i < NUM_THREAD; i++)
+      if (thread_join(thread[i], &ret) != 0 || (int)ret != 10)
+        failed("thread_join");
+  }
+  printf(1, "TLS ok\n");
+  printf(1, "All tests Passed\n");
+  exit();
+}
@@ -0,0 +1,71 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "procstat.h"
+
+// Thread create/join throughput.
+// usage: thread_bench [total]
+// For each width n, creates n threads, joins them all, and
+// repeats until total threads have run; prints the time per
+// create+join. Widths above 64 need the thread table to grow
+// on demand. After the first round the threads reuse the user
+// stacks of joined ones, so later rounds do not grow the process.
+// The first round of each width also checks that getthreadstat
+// reports all n threads and the main one.
+
+#define MAXTHREAD 1000
+
+int widths[] = {1, 10, 100, 1000};
+thread_t tids[MAXTHREAD];
+struct threadstat ts[MAXTHREAD + 1];
+
+void*
+worker(void *arg)
+{
+  thread_exit(arg);
+  return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int total, n, i, j, k, rounds, start, ticks;
+  void *ret;
+
+  total = 2000;
+  if(argc > 1)
+    total = atoi(argv[1]);
+
+  printf(1, "threads  rounds  ticks  us per create+join\n");
+  for(k = 0; k < sizeof(widths) / sizeof(widths[0]); k++){
+    n = widths[k];
+    rounds = total / n;
+    if(rounds < 1)
+      rounds = 1;
+    start = uptime();
+    for(i = 0; i < rounds; i++){
+      for(j = 0; j < n; j++){
+        if(thread_create(&tids[j], worker, (void*)j) != 0){
+          printf(1, "thread_create failed at %d of %d\n", j, n);
+          exit();
+        }
+      }
+      // Exited threads stay listed until they are joined.
+      if(i == 0 && getthreadstat(getpid(), ts, n + 1) != n + 1){
+        printf(1, "getthreadstat did not report %d threads\n", n + 1);
+        exit();
+      }
+      for(j = 0; j < n; j++){
+        if(thread_join(tids[j], &ret) != 0 || (int)ret != j){
+          printf(1, "thread_join failed\n");
+          exit();
+        }
+      }
+    }
+    ticks = uptime() - start;
+    // A tick is 10ms.
+    printf(1, "%d  %d  %d  %d\n", n, rounds, ticks,
+           ticks * 10000 / (rounds * n));
+  }
+  exit();
+}
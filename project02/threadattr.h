@@ -0,0 +1,7 @@
+// Attributes for thread_create_attr(). Zero fields take the
+// defaults of thread_create(): a one-page stack and no TLS.
+struct thread_attr {
+  uint stacksize;  // User stack (bytes), below a guard page
+  uint tlssize;    // Thread-local storage (bytes), zeroed, at %gs:0;
+                   // its first word points to itself (see tls_get)
+};
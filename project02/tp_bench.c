@@ -0,0 +1,146 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fcntl.h"
+#include "tpool.h"
+
+// Thread pool benchmark.
+// usage: tp_bench [maxworkers]
+// Times a parallel sum over an array and a parallel grep over
+// program files loaded in memory, serially and with pools of
+// 1, 2, 4, ... workers. Run it with CPUS=4 to see the scaling.
+
+#define NELEM (1024 * 1024)
+#define SUMROUNDS 10
+#define GREPROUNDS 20
+#define MAXFILES 12
+
+int *array;
+
+char *files[MAXFILES] = {
+  "cat", "echo", "grep", "kill", "ln", "ls",
+  "mkdir", "rm", "sh", "wc", "zombie", "pmanager"
+};
+char *data[MAXFILES];
+int size[MAXFILES];
+int nfiles;
+char *pattern = "the";
+
+int
+sum(void *arg, int lo, int hi)
+{
+  int s = 0;
+
+  for(; lo < hi; lo++)
+    s += array[lo];
+  return s;
+}
+
+int
+add(int a, int b)
+{
+  return a + b;
+}
+
+// Occurrences of pattern in files lo..hi-1.
+int
+grep(void *arg, int lo, int hi)
+{
+  int n = 0, i, k, len;
+
+  len = strlen(pattern);
+  for(; lo < hi; lo++){
+    for(i = 0; i + len <= size[lo]; i++){
+      for(k = 0; k < len && data[lo][i + k] == pattern[k]; k++)
+        ;
+      if(k == len)
+        n++;
+    }
+  }
+  return n;
+}
+
+void
+loadfiles(void)
+{
+  struct stat st;
+  int i, fd;
+
+  for(i = 0; i < MAXFILES; i++){
+    if((fd = open(files[i], O_RDONLY)) < 0)
+      continue;
+    if(fstat(fd, &st) < 0 || (data[nfiles] = malloc(st.size)) == 0){
+      close(fd);
+      continue;
+    }
+    size[nfiles] = read(fd, data[nfiles], st.size);
+    close(fd);
+    nfiles++;
+  }
+}
+
+// Prints the ticks of both benchmarks with the current pool.
+void
+run(int workers, int *sumbase, int *grepbase)
+{
+  int i, r, start, tsum, tgrep, matches;
+
+  start = uptime();
+  for(r = 0; r < SUMROUNDS; r++){
+    if(parallel_reduce(0, NELEM, 4096, sum, add, 0, 0) != NELEM){
+      printf(1, "wrong sum\n");
+      exit();
+    }
+  }
+  tsum = uptime() - start;
+
+  start = uptime();
+  matches = 0;
+  for(r = 0; r < GREPROUNDS; r++)
+    for(i = 0; i < 4; i++)
+      matches = parallel_reduce(0, nfiles, 1, grep, add, 0, 0);
+  tgrep = uptime() - start;
+
+  if(tsum == 0)
+    tsum = 1;
+  if(tgrep == 0)
+    tgrep = 1;
+  if(workers == 0){
+    *sumbase = tsum;
+    *grepbase = tgrep;
+  }
+  printf(1, "%d  %d  %d  %d  %d  (%d matches)\n", workers, tsum,
+         *sumbase * 100 / tsum, tgrep, *grepbase * 100 / tgrep, matches);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int max, n, i, sumbase, grepbase;
+
+  max = 4;
+  if(argc > 1)
+    max = atoi(argv[1]);
+  if(max < 1 || max > TP_MAXWORKERS)
+    max = TP_MAXWORKERS;
+
+  if((array = malloc(NELEM * sizeof(int))) == 0){
+    printf(1, "malloc failed\n");
+    exit();
+  }
+  for(i = 0; i < NELEM; i++)
+    array[i] = 1;
+  loadfiles();
+
+  printf(1, "workers  sum ticks  speedup x100  grep ticks  speedup x100\n");
+  run(0, &sumbase, &grepbase);
+  for(n = 1; n <= max; n *= 2){
+    if(tp_init(n) < 0){
+      printf(1, "tp_init failed\n");
+      exit();
+    }
+    run(n, &sumbase, &grepbase);
+    tp_exit();
+  }
+  exit();
+}
@@ -0,0 +1,331 @@
+// Thread pool with work-stealing deques (see tpool.h).
+//
+// Each thread of the pool owns a Chase-Lev deque of tasks: it
+// pushes and pops at the bottom, thieves take from the top, and
+// only a take of the last task races with the owner, which is
+// settled with a compare-and-swap on top. The deques have a fixed
+// size; when one is full the range is run without splitting.
+// Slot 0 belongs to the thread that made the pool, slots 1..n to
+// the workers, which find theirs in their thread-local storage.
+//
+// An idle worker spins for a while, then sleeps on the futex
+// pool.seq; a push wakes one sleeper.
+
+#include "types.h"
+#include "user.h"
+#include "x86.h"
+#include "threadattr.h"
+#include "tpool.h"
+
+#define DEQUESIZE 1024         // Tasks per deque, a power of 2
+#define IDLESPIN 100           // Failed steal rounds before sleeping
+#define STACKSIZE (16*1024)
+
+// One call of parallel_for or parallel_reduce.
+struct job {
+  void (*forfn)(void*, int, int);
+  int (*reducefn)(void*, int, int);
+  int (*combine)(int, int);
+  void *arg;
+  int grain;
+  volatile uint pending;       // Ranges not finished yet
+  volatile int result;
+};
+
+struct task {
+  struct job *job;
+  int lo;
+  int hi;
+};
+
+struct deque {
+  volatile int top;            // Thieves take here
+  volatile int bottom;         // The owner pushes and pops here
+  struct task task[DEQUESIZE];
+};
+
+// Thread-local storage of a worker.
+struct tpself {
+  struct tpself *self;         // Set by the kernel
+  int id;
+};
+
+static struct {
+  int n;                       // Workers
+  struct deque *dq;            // n+1 deques
+  thread_t tid[TP_MAXWORKERS];
+  volatile int stop;
+  volatile uint seq;           // Futex the idle workers sleep on
+  volatile int nsleep;
+} pool;
+
+static int
+push(struct deque *d, struct task *t)
+{
+  int b = d->bottom;
+
+  if(b - d->top >= DEQUESIZE)
+    return -1;
+  d->task[b & (DEQUESIZE-1)] = *t;
+  // x86 does not reorder stores: the task is visible first.
+  asm volatile("" ::: "memory");
+  d->bottom = b + 1;
+  return 0;
+}
+
+static int
+pop(struct deque *d, struct task *t)
+{
+  int b, top, r;
+
+  b = d->bottom - 1;
+  d->bottom = b;
+  // The store to bottom must be seen before top is read.
+  __sync_synchronize();
+  top = d->top;
+  if(top > b){
+    d->bottom = b + 1;
+    return 0;
+  }
+  *t = d->task[b & (DEQUESIZE-1)];
+  if(top < b)
+    return 1;
+  // The last task: a thief may be taking it too.
+  r = __sync_bool_compare_and_swap(&d->top, top, top + 1);
+  d->bottom = b + 1;
+  return r;
+}
+
+static int
+steal(struct deque *d, struct task *t)
+{
+  int top, b;
+
+  top = d->top;
+  __sync_synchronize();
+  b = d->bottom;
+  if(top >= b)
+    return 0;
+  *t = d->task[top & (DEQUESIZE-1)];
+  return __sync_bool_compare_and_swap(&d->top, top, top + 1);
+}
+
+// Slot of the calling thread.
+static int
+myid(void)
+{
+  struct tpself *s = tls_get();
+
+  return s ? s->id : 0;
+}
+
+static void
+wakeworker(void)
+{
+  // Pairs with the increment of nsleep in worker(): either the
+  // sleeper sees the new task or we see the sleeper.
+  __sync_synchronize();
+  if(pool.nsleep > 0){
+    __sync_fetch_and_add(&pool.seq, 1);
+    futex_wake(&pool.seq, 1);
+  }
+}
+
+static void
+finish(struct job *j, int r)
+{
+  int old;
+
+  if(j->reducefn){
+    do
+      old = j->result;
+    while(!__sync_bool_compare_and_swap(&j->result, old, j->combine(old, r)));
+  }
+  if(__sync_sub_and_fetch(&j->pending, 1) == 0)
+    futex_wake(&j->pending, -1);
+}
+
+// Run [lo, hi) of j, pushing its upper halves for others to steal.
+static void
+runrange(struct job *j, int lo, int hi, int id)
+{
+  struct task t;
+  int mid, r = 0;
+
+  while(hi - lo > j->grain){
+    mid = lo + (hi - lo) / 2;
+    t.job = j;
+    t.lo = mid;
+    t.hi = hi;
+    __sync_fetch_and_add(&j->pending, 1);
+    if(push(&pool.dq[id], &t) < 0){
+      __sync_fetch_and_sub(&j->pending, 1);
+      break;
+    }
+    wakeworker();
+    hi = mid;
+  }
+  if(j->reducefn)
+    r = j->reducefn(j->arg, lo, hi);
+  else
+    j->forfn(j->arg, lo, hi);
+  finish(j, r);
+}
+
+// Run one task, our own or a stolen one. Returns 0 if there
+// was none.
+static int
+runone(int id)
+{
+  struct task t;
+  int i, v;
+
+  if(pop(&pool.dq[id], &t)){
+    runrange(t.job, t.lo, t.hi, id);
+    return 1;
+  }
+  for(i = 1; i <= pool.n; i++){
+    v = (id + i) % (pool.n + 1);
+    if(steal(&pool.dq[v], &t)){
+      runrange(t.job, t.lo, t.hi, id);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int
+anywork(void)
+{
+  int i;
+
+  for(i = 0; i <= pool.n; i++)
+    if(pool.dq[i].top < pool.dq[i].bottom)
+      return 1;
+  return 0;
+}
+
+static void*
+worker(void *arg)
+{
+  struct tpself *s = tls_get();
+  int idle = 0;
+  uint seq;
+
+  s->id = (int)arg;
+  while(!pool.stop){
+    if(runone(s->id)){
+      idle = 0;
+      continue;
+    }
+    if(++idle < IDLESPIN)
+      continue;
+    seq = pool.seq;
+    __sync_fetch_and_add(&pool.nsleep, 1);
+    if(!anywork() && !pool.stop)
+      futex_wait(&pool.seq, seq);
+    __sync_fetch_and_sub(&pool.nsleep, 1);
+    idle = 0;
+  }
+  thread_exit(0);
+  return 0;
+}
+
+// Start nworkers worker threads. Returns 0, or -1.
+int
+tp_init(int nworkers)
+{
+  struct thread_attr attr;
+  int i;
+
+  if(pool.n > 0 || nworkers < 1 || nworkers > TP_MAXWORKERS)
+    return -1;
+  if((pool.dq = malloc((nworkers + 1) * sizeof(struct deque))) == 0)
+    return -1;
+  memset(pool.dq, 0, (nworkers + 1) * sizeof(struct deque));
+  pool.stop = 0;
+  pool.nsleep = 0;
+  pool.n = nworkers;
+  attr.stacksize = STACKSIZE;
+  attr.tlssize = sizeof(struct tpself);
+  for(i = 0; i < nworkers; i++){
+    if(thread_create_attr(&pool.tid[i], worker, (void*)(i + 1), &attr) != 0){
+      pool.n = i;
+      tp_exit();
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// Stop the workers and wait for them.
+void
+tp_exit(void)
+{
+  void *ret;
+  int i;
+
+  pool.stop = 1;
+  __sync_fetch_and_add(&pool.seq, 1);
+  futex_wake(&pool.seq, -1);
+  for(i = 0; i < pool.n; i++)
+    thread_join(pool.tid[i], &ret);
+  free(pool.dq);
+  pool.dq = 0;
+  pool.n = 0;
+}
+
+// Run j over [lo, hi) and help with any task until it is done.
+static void
+runjob(struct job *j, int lo, int hi)
+{
+  int id = myid();
+  uint pending;
+
+  j->pending = 1;
+  runrange(j, lo, hi, id);
+  while((pending = j->pending) != 0){
+    if(runone(id))
+      continue;
+    // The rest is running elsewhere.
+    futex_wait(&j->pending, pending);
+  }
+}
+
+void
+parallel_for(int lo, int hi, int grain, void (*fn)(void*, int, int), void *arg)
+{
+  struct job j;
+
+  if(lo >= hi)
+    return;
+  if(pool.n == 0){
+    fn(arg, lo, hi);
+    return;
+  }
+  memset(&j, 0, sizeof(j));
+  j.forfn = fn;
+  j.arg = arg;
+  j.grain = grain < 1 ? 1 : grain;
+  runjob(&j, lo, hi);
+}
+
+int
+parallel_reduce(int lo, int hi, int grain, int (*fn)(void*, int, int),
+                int (*combine)(int, int), int identity, void *arg)
+{
+  struct job j;
+
+  if(lo >= hi)
+    return identity;
+  if(pool.n == 0)
+    return combine(identity, fn(arg, lo, hi));
+  memset(&j, 0, sizeof(j));
+  j.reducefn = fn;
+  j.combine = combine;
+  j.arg = arg;
+  j.grain = grain < 1 ? 1 : grain;
+  j.result = identity;
+  runjob(&j, lo, hi);
+  return j.result;
+}
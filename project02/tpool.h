@@ -0,0 +1,19 @@
+// Thread pool with work stealing (tpool.c).
+//
+// tp_init(n) starts n worker threads. parallel_for() and
+// parallel_reduce() split [lo, hi) in halves down to grain
+// iterations; the halves go on the deque of the thread that split
+// them, and idle workers steal from the other end. The calling
+// thread helps until its whole range is done, so the calls may
+// nest inside tasks. Call them from the thread that made the pool
+// or from inside a task. Without a pool they run serially.
+
+#define TP_MAXWORKERS 16
+
+int tp_init(int nworkers);
+void tp_exit(void);
+void parallel_for(int lo, int hi, int grain,
+                  void (*fn)(void *arg, int lo, int hi), void *arg);
+int parallel_reduce(int lo, int hi, int grain,
+                    int (*fn)(void *arg, int lo, int hi),
+                    int (*combine)(int, int), int identity, void *arg);
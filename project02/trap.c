@@ -36,11 +36,17 @@ idtinit(void)
 void
 trap(struct trapframe *tf)
 {
+  struct thread *t;
+
   if(tf->trapno == T_SYSCALL){
     if(myproc()->killed)
       exit();
-    mythread(myproc())->tf = tf;
+    t = mythread();
+    t->tf = tf;
+    // Keep swapout() away from the user memory the call uses.
+    t->insyscall = 1;
     syscall();
+    t->insyscall = 0;
     if(myproc()->killed)
       exit();
     return;
@@ -71,6 +77,10 @@ trap(struct trapframe *tf)
     uartintr();
     lapiceoi();
     break;
+  case T_TLBFLUSH:
+    tlbpoll();
+    lapiceoi();
+    break;
   case T_IRQ0 + 7:
   case T_IRQ0 + IRQ_SPURIOUS:
     cprintf("cpu%d: spurious interrupt at %x:%x\n",
@@ -78,6 +88,18 @@ trap(struct trapframe *tf)
     lapiceoi();
     break;
 
+  case T_PGFLT:
+    // A write to a copy-on-write page or the first touch of a
+    // program or heap page, by the process or by the kernel using
+    // its memory in a system call. Program pages are read from the
+    // file, which sleeps; allow that if the faulting code could be
+    // interrupted.
+    if(tf->eflags & FL_IF)
+      sti();
+    if(pagefault(rcr2(), tf->err) == 0)
+      break;
+    // Otherwise a real fault.
+
   //PAGEBREAK: 13
   default:
     if(myproc() == 0 || (tf->cs&3) == 0){
@@ -102,7 +124,7 @@ trap(struct trapframe *tf)
 
   // Force process to give up CPU on clock tick.
   // If interrupts were on while locks held, would need to check nlock.
-  if(myproc() && mythread(myproc())->state == RUNNING &&
+  if(myproc() && mythread()->state == RUNNING &&
      tf->trapno == T_IRQ0+IRQ_TIMER)
     yield();
 
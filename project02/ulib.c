@@ -134,4 +134,122 @@ my_strtok(char *str, const char* delimiters)
   }
 
   return str;
-}
\ No newline at end of file
+}
+
+// Mutex, condition variable and barrier for threads.
+// Uncontended operations stay in user space; a thread that has to
+// wait sleeps in futex_wait() until another one calls futex_wake().
+
+// state: 0 unlocked, 1 locked, 2 locked and maybe contended.
+void
+mutex_init(struct mutex *m)
+{
+  m->state = 0;
+}
+
+void
+mutex_lock(struct mutex *m)
+{
+  uint c;
+
+  if((c = __sync_val_compare_and_swap(&m->state, 0, 1)) == 0)
+    return;
+  // Mark it contended, so the holder wakes us when it unlocks.
+  if(c != 2)
+    c = xchg(&m->state, 2);
+  while(c != 0){
+    futex_wait(&m->state, 2);
+    c = xchg(&m->state, 2);
+  }
+}
+
+void
+mutex_unlock(struct mutex *m)
+{
+  if(xchg(&m->state, 0) == 2)
+    futex_wake(&m->state, 1);
+}
+
+void
+cond_init(struct cond *c)
+{
+  c->seq = 0;
+}
+
+// Waiters sleep until seq moves on from the value they saw
+// while holding m, so a signal between mutex_unlock() and
+// futex_wait() is not lost.
+void
+cond_wait(struct cond *c, struct mutex *m)
+{
+  uint seq = c->seq;
+
+  mutex_unlock(m);
+  futex_wait(&c->seq, seq);
+  // Others may be waiting for m as well: take it contended.
+  while(xchg(&m->state, 2) != 0)
+    futex_wait(&m->state, 2);
+}
+
+void
+cond_signal(struct cond *c)
+{
+  __sync_fetch_and_add(&c->seq, 1);
+  futex_wake(&c->seq, 1);
+}
+
+void
+cond_broadcast(struct cond *c)
+{
+  __sync_fetch_and_add(&c->seq, 1);
+  futex_wake(&c->seq, -1);
+}
+
+void
+barrier_init(struct barrier *b, uint n)
+{
+  mutex_init(&b->lock);
+  cond_init(&b->cond);
+  b->n = n;
+  b->count = 0;
+  b->phase = 0;
+}
+
+// Wait until n threads have called barrier_wait().
+// Returns 1 in the last thread to arrive, 0 in the others.
+int
+barrier_wait(struct barrier *b)
+{
+  uint phase;
+  int last = 0;
+
+  mutex_lock(&b->lock);
+  phase = b->phase;
+  if(++b->count == b->n){
+    b->count = 0;
+    b->phase++;
+    cond_broadcast(&b->cond);
+    last = 1;
+  } else {
+    while(b->phase == phase)
+      cond_wait(&b->cond, &b->lock);
+  }
+  mutex_unlock(&b->lock);
+  return last;
+}
+
+// Thread-local storage of the calling thread, made by
+// thread_create_attr(); its first word points to itself.
+// Returns 0 in a thread without one, whose %gs is null.
+void*
+tls_get(void)
+{
+  ushort gs;
+  void *p;
+
+  asm volatile("movw %%gs, %0" : "=r" (gs));
+  if(gs == 0)
+    return 0;
+  asm volatile("movl %%gs:0, %0" : "=r" (p));
+  return p;
+}
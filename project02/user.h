@@ -1,5 +1,26 @@
 struct stat;
 struct rtcdate;
+struct kmemstat;
+struct procstat;
+struct threadstat;
+struct thread_attr;
+
+// Mutex, condition variable and barrier for threads (ulib.c).
+struct mutex {
+  volatile uint state;
+};
+
+struct cond {
+  volatile uint seq;
+};
+
+struct barrier {
+  struct mutex lock;
+  struct cond cond;
+  uint n;
+  uint count;
+  uint phase;
+};
 
 // system calls
 int fork(void);
@@ -29,6 +50,13 @@ void list(void);
 int thread_create(thread_t*thread, void *(*start_routine)(void *), void *arg);
 void thread_exit(void *retval);
 int thread_join(thread_t thread, void **retval);
+int thread_create_attr(thread_t*, void *(*)(void *), void *, struct thread_attr*);
+int getkmemstat(struct kmemstat*);
+int setcowfork(int);
+int getprocstat(struct procstat*, int);
+int getthreadstat(int, struct threadstat*, int);
+int futex_wait(volatile uint*, uint);
+int futex_wake(volatile uint*, int);
 
 // ulib.c
 int stat(const char*, struct stat*);
@@ -43,4 +71,14 @@ void* memset(void*, int, uint);
 void* malloc(uint);
 void free(void*);
 int atoi(const char*);
-char *my_strtok(char *, const char *);
\ No newline at end of file
+char *my_strtok(char *, const char *);
+void mutex_init(struct mutex*);
+void mutex_lock(struct mutex*);
+void mutex_unlock(struct mutex*);
+void cond_init(struct cond*);
+void cond_wait(struct cond*, struct mutex*);
+void cond_signal(struct cond*);
+void cond_broadcast(struct cond*);
+void barrier_init(struct barrier*, uint);
+int barrier_wait(struct barrier*);
+void* tls_get(void);
\ No newline at end of file
@@ -6,10 +6,19 @@
 #include "mmu.h"
 #include "proc.h"
 #include "elf.h"
+#include "traps.h"
+#include "procstat.h"
+#include "spinlock.h"
 
 extern char data[];  // defined by kernel.ld
 pde_t *kpgdir;  // for use in scheduler()
 
+// Serializes page faults, so that threads sharing a page table
+// do not both copy or allocate the same page.
+static struct spinlock pflock;
+
+#define UFREEMIN 32   // Free pages ualloc() leaves to the kernel
+
 // Set up CPU's kernel segment descriptors.
 // Run once on entry on each CPU.
 void
@@ -142,6 +151,7 @@ kvmalloc(void)
 {
   kpgdir = setupkvm();
   switchkvm();
+  initlock(&pflock, "pagefault");
 }
 
 // Switch h/w page table register to the kernel-only page table,
@@ -150,15 +160,20 @@ void
 switchkvm(void)
 {
   lcr3(V2P(kpgdir));   // switch to the kernel page table
+  if(ncpu > 0)
+    mycpu()->pgdir = 0;
 }
 
-// Switch TSS and h/w page table to correspond to process p.
+// Switch TSS and h/w page table to correspond to process p,
+// and the TLS segment to the current thread of p.
 void
 switchuvm(struct proc *p)
 {
+  struct thread *t = mythread();
+
   if(p == 0)
     panic("switchuvm: no process");
-  if(mythread(p)->kstack == 0)
+  if(t->kstack == 0)
     panic("switchuvm: no kstack");
   if(p->pgdir == 0)
     panic("switchuvm: no pgdir");
@@ -168,15 +183,63 @@ switchuvm(struct proc *p)
                                 sizeof(mycpu()->ts)-1, 0);
   mycpu()->gdt[SEG_TSS].s = 0;
   mycpu()->ts.ss0 = SEG_KDATA << 3;
-  mycpu()->ts.esp0 = (uint)mythread(p)->kstack + KSTACKSIZE;
+  mycpu()->ts.esp0 = (uint)t->kstack + KSTACKSIZE;
   // setting IOPL=0 in eflags *and* iomb beyond the tss segment limit
   // forbids I/O instructions (e.g., inb and outb) from user space
   mycpu()->ts.iomb = (ushort) 0xFFFF;
   ltr(SEG_TSS << 3);
+  // %gs of the thread is loaded from here by trapret. The segment
+  // stays present without TLS, so a stale %gs cannot fault there.
+  mycpu()->gdt[SEG_UTLS] = SEG(STA_W, t->tls,
+                               t->tls ? t->tlspages*PGSIZE - 1 : 0, DPL_USER);
+  // Published before the TLB can hold entries of p->pgdir, so
+  // that tlbshootdown() sees this cpu.
+  mycpu()->pgdir = p->pgdir;
   lcr3(V2P(p->pgdir));  // switch to process's address space
   popcli();
 }
 
+// Flush the TLB of this cpu if another cpu asked for it in
+// tlbshootdown(). Called with interrupts off: from the IPI, and
+// while spinning, so that a cpu waiting for a lock we hold does
+// not keep us waiting for it.
+void
+tlbpoll(void)
+{
+  struct cpu *c = mycpu();
+
+  // Cleared first: a request made after this is served by the
+  // flush below or by the next IPI.
+  if(c->tlbflush && xchg(&c->tlbflush, 0))
+    lcr3(rcr3());
+}
+
+// The PTEs of pgdir changed; make the other cpus running it drop
+// their TLB entries, and wait until they have.
+void
+tlbshootdown(pde_t *pgdir)
+{
+  struct cpu *c;
+  uint sent = 0;
+  int i;
+
+  pushcli();
+  // The PTE stores before the loads of c->pgdir.
+  __sync_synchronize();
+  for(i = 0; i < ncpu; i++){
+    c = &cpus[i];
+    if(c == mycpu() || c->pgdir != pgdir)
+      continue;
+    c->tlbflush = 1;
+    lapicipi(c->apicid, T_TLBFLUSH);
+    sent |= 1 << i;
+  }
+  for(i = 0; i < ncpu; i++)
+    while((sent & (1 << i)) && cpus[i].tlbflush)
+      tlbpoll();
+  popcli();
+}
+
 // Load the initcode into address 0 of pgdir.
 // sz must be less than a page.
 void
@@ -216,6 +279,43 @@ loaduvm(pde_t *pgdir, char *addr, struct inode *ip, uint offset, uint sz)
   return 0;
 }
 
+// kalloc() for a user page. When memory runs low, makes room
+// by pushing a page out to swap, if the caller can sleep; a few
+// pages are kept free for page tables and kernel stacks.
+static char*
+ualloc(void)
+{
+  char *mem;
+
+  if(kfreepages() < UFREEMIN && (readeflags() & FL_IF))
+    swapout();
+  while((mem = kalloc()) == 0)
+    if(!(readeflags() & FL_IF) || swapout() < 0)
+      return 0;
+  return mem;
+}
+
+// Share the swapped-out page at va of pte with the page table d
+// of a child, for fork. Returns 0, 1 if it is no longer in swap
+// (another thread read it back in), or -1 if out of memory.
+static int
+swapshare(pte_t *pte, pde_t *d, uint va)
+{
+  pte_t *npte;
+  int r = 1;
+
+  if((npte = walkpgdir(d, (char*)va, 1)) == 0)
+    return -1;
+  acquire(&pflock);
+  if(*pte & PTE_SWAP){
+    swapdup(PTE_SLOT(*pte));
+    *npte = *pte;
+    r = 0;
+  }
+  release(&pflock);
+  return r;
+}
+
 // Allocate page tables and physical memory to grow process from oldsz to
 // newsz, which need not be page aligned.  Returns new size or 0 on error.
 int
@@ -231,7 +331,7 @@ allocuvm(pde_t *pgdir, uint oldsz, uint newsz)
 
   a = PGROUNDUP(oldsz);
   for(; a < newsz; a += PGSIZE){
-    mem = kalloc();
+    mem = ualloc();
     if(mem == 0){
       cprintf("allocuvm out of memory\n");
       deallocuvm(pgdir, newsz, oldsz);
@@ -272,6 +372,9 @@ deallocuvm(pde_t *pgdir, uint oldsz, uint newsz)
       char *v = P2V(pa);
       kfree(v);
       *pte = 0;
+    } else if(*pte & PTE_SWAP){
+      swapfree(PTE_SLOT(*pte));
+      *pte = 0;
     }
   }
   return newsz;
@@ -318,17 +421,25 @@ copyuvm(pde_t *pgdir, uint sz)
   pte_t *pte;
   uint pa, i, flags;
   char *mem;
+  int r;
 
   if((d = setupkvm()) == 0)
     return 0;
   for(i = 0; i < sz; i += PGSIZE){
     if((pte = walkpgdir(pgdir, (void *) i, 0)) == 0)
-      panic("copyuvm: pte should exist");
+      continue;
+    if(*pte & PTE_SWAP){
+      if((r = swapshare(pte, d, i)) < 0)
+        goto bad;
+      if(r == 0)
+        continue;
+    }
+    // Heap pages not touched yet are left out (see growproc).
     if(!(*pte & PTE_P))
-      panic("copyuvm: page not present");
+      continue;
     pa = PTE_ADDR(*pte);
     flags = PTE_FLAGS(*pte);
-    if((mem = kalloc()) == 0)
+    if((mem = ualloc()) == 0)
       goto bad;
     memmove(mem, (char*)P2V(pa), PGSIZE);
     if(mappages(d, (void*)i, PGSIZE, V2P(mem), flags) < 0) {
@@ -343,6 +454,445 @@ bad:
   return 0;
 }
 
+// Like copyuvm, but share the pages with the child: writable
+// pages become read-only PTE_COW pages in both page tables,
+// and cowfault() copies them on the first write.
+// pgdir must be the current page table.
+pde_t*
+cowuvm(pde_t *pgdir, uint sz)
+{
+  pde_t *d;
+  pte_t *pte;
+  uint pa, i;
+  char *mem;
+  int r;
+
+  if((d = setupkvm()) == 0)
+    return 0;
+  for(i = 0; i < sz; i += PGSIZE){
+    if((pte = walkpgdir(pgdir, (void *) i, 0)) == 0)
+      continue;
+    if(*pte & PTE_SWAP){
+      if((r = swapshare(pte, d, i)) < 0)
+        goto bad;
+      if(r == 0)
+        continue;
+    }
+    if(!(*pte & PTE_P))
+      continue;
+    pa = PTE_ADDR(*pte);
+    if(*pte & PTE_FUTEX){
+      // Threads may sleep on a futex keyed by this page (see
+      // futexwait in proc.c): keep it ours and copy it now.
+      if((mem = kalloc()) == 0)
+        goto bad;
+      memmove(mem, P2V(pa), PGSIZE);
+      if(mappages(d, (void*)i, PGSIZE, V2P(mem), PTE_FLAGS(*pte) & ~PTE_FUTEX) < 0){
+        kfree(mem);
+        goto bad;
+      }
+      continue;
+    }
+    if(*pte & PTE_W)
+      *pte = (*pte & ~PTE_W) | PTE_COW;
+    if(mappages(d, (void*)i, PGSIZE, pa, PTE_FLAGS(*pte)) < 0)
+      goto bad;
+    kref(P2V(pa));
+  }
+  // Drop the writable TLB entries of the parent.
+  lcr3(V2P(pgdir));
+  return d;
+
+bad:
+  // The pages left PTE_COW are made writable again on a fault.
+  lcr3(V2P(pgdir));
+  freevm(d);
+  return 0;
+}
+
+// Kernel address of the user word at va of pgdir, for a futex.
+// Futexes are keyed by physical address, so the page must not
+// move under its waiters: a copy-on-write page is made private
+// first, and the page is marked PTE_FUTEX so that a later fork
+// copies it instead of sharing it (see cowuvm).
+// Caller holds ptable.lock and has touched va (see uvmtouch).
+// Returns 0 if va is not a mapped user word.
+uint*
+uvmfutex(pde_t *pgdir, uint va)
+{
+  pte_t *pte;
+  uint *w = 0;
+
+  if(va % 4 != 0 || va >= KERNBASE)
+    return 0;
+  pte = walkpgdir(pgdir, (char*)va, 0);
+  if(pte && (*pte & PTE_COW) && cowfault(pgdir, va) < 0)
+    return 0;
+  acquire(&pflock);
+  if(pte && (*pte & (PTE_P|PTE_U|PTE_COW)) == (PTE_P|PTE_U)){
+    *pte |= PTE_FUTEX;
+    w = (uint*)(P2V(PTE_ADDR(*pte)) + (va & (PGSIZE-1)));
+  }
+  release(&pflock);
+  return w;
+}
+
+// Make the copy-on-write page at va writable in pgdir, copying
+// it unless no other page table shares it any more. Called on a
+// write fault, and before the kernel writes to user memory
+// through copyout().
+// Returns 0, or -1 if va is not a copy-on-write page or there
+// is no memory for the copy.
+int
+cowfault(pde_t *pgdir, uint va)
+{
+  pte_t *pte;
+  char *mem, *old = 0;
+  int r = -1;
+
+  if(va >= KERNBASE)
+    return -1;
+retry:
+  acquire(&pflock);
+  pte = walkpgdir(pgdir, (char*)va, 0);
+  if(pte == 0 || (*pte & (PTE_P|PTE_U)) != (PTE_P|PTE_U))
+    goto out;
+  if(*pte & PTE_W){
+    // Another thread made it writable; our TLB entry was stale.
+    r = 0;
+    goto out;
+  }
+  if(!(*pte & PTE_COW))
+    goto out;
+  old = P2V(PTE_ADDR(*pte));
+  if(krefs(old) == 1 && !pccached(old)){
+    // Stale read-only TLB entries elsewhere only cause another
+    // fault, which finds the page writable.
+    *pte = (*pte | PTE_W) & ~PTE_COW;
+    old = 0;
+  } else {
+    if((mem = kalloc()) == 0){
+      // Make room if we may sleep, then look again.
+      release(&pflock);
+      if((readeflags() & FL_IF) && swapout() == 0)
+        goto retry;
+      return -1;
+    }
+    memmove(mem, old, PGSIZE);
+    *pte = V2P(mem) | ((PTE_FLAGS(*pte) | PTE_W) & ~PTE_COW);
+  }
+  r = 0;
+
+out:
+  release(&pflock);
+  if(r == 0 && myproc() && myproc()->pgdir == pgdir)
+    lcr3(V2P(pgdir));
+  if(old){
+    // Other threads may still read the old page through their
+    // TLBs; it is not freed, and so given to the process that
+    // shares it, until they have dropped them.
+    tlbshootdown(pgdir);
+    kfree(old);
+  }
+  return r;
+}
+
+// Map a zeroed page at va, a heap page that sbrk reserved and p
+// touches for the first time, unless p would go over its memlim.
+// Returns 0, or -1 if the page cannot be mapped.
+static int
+lazyfault(struct proc *p, uint va)
+{
+  pte_t *pte;
+  char *mem;
+  int r = -1;
+
+  va = PGROUNDDOWN(va);
+  if(p->memlim != 0 && (p->rss + 1) * PGSIZE > p->memlim)
+    return -1;
+  if((mem = ualloc()) == 0)
+    return -1;
+  memset(mem, 0, PGSIZE);
+  acquire(&pflock);
+  if((pte = walkpgdir(p->pgdir, (char*)va, 0)) != 0 && (*pte & PTE_P)){
+    // Another thread mapped it first.
+    r = 0;
+    goto out;
+  }
+  if(p->memlim != 0 && (p->rss + 1) * PGSIZE > p->memlim)
+    goto out;
+  if(mappages(p->pgdir, (char*)va, PGSIZE, V2P(mem), PTE_W|PTE_U) < 0)
+    goto out;
+  p->rss++;
+  mem = 0;
+  r = 0;
+
+out:
+  release(&pflock);
+  if(mem)
+    kfree(mem);
+  return r;
+}
+
+// Map the page at va of program segment s of p's executable:
+// the copy in the page cache (see pcache.c) if another process
+// has it, else one read from the file now. The page is shared
+// read-only, and copied by cowfault() if p writes to it.
+// Reading the file sleeps, so this fails if the fault came from
+// code that cannot (interrupts off, spinlocks held).
+// Returns 0, or -1 if the page cannot be mapped.
+static int
+execfault(struct proc *p, struct execseg *s, uint va)
+{
+  pte_t *pte;
+  char *mem, *page;
+  uint a, n;
+  int r = -1;
+
+  if(!(readeflags() & FL_IF))
+    return -1;
+  va = PGROUNDDOWN(va);
+  if(p->memlim != 0 && (p->rss + 1) * PGSIZE > p->memlim)
+    return -1;
+  a = va - s->vaddr;
+  if((mem = pcget(p->exe, s->off + a)) == 0){
+    if((page = ualloc()) == 0)
+      return -1;
+    memset(page, 0, PGSIZE);
+    n = s->filesz - a;
+    if(n > PGSIZE)
+      n = PGSIZE;
+    ilock(p->exe);
+    if(readi(p->exe, page, s->off + a, n) != n){
+      iunlock(p->exe);
+      kfree(page);
+      return -1;
+    }
+    // Enter it while ip is locked, so a writer of the file
+    // cannot drop the entries before this one is added.
+    mem = pcadd(p->exe, s->off + a, page);
+    iunlock(p->exe);
+    if(mem != page)
+      kfree(page);
+  }
+
+  // Another thread may have faulted the page in while we slept.
+  acquire(&pflock);
+  if((pte = walkpgdir(p->pgdir, (char*)va, 0)) != 0 && (*pte & PTE_P))
+    r = 0;
+  else if(mappages(p->pgdir, (char*)va, PGSIZE, V2P(mem), PTE_U|PTE_COW) == 0){
+    p->rss++;
+    mem = 0;
+    r = 0;
+  }
+  release(&pflock);
+  if(mem)
+    kfree(mem);
+  return r;
+}
+
+// Count a fault that was resolved (r is 0) for the process and
+// for the thread that took it.
+static int
+counted(int r, uint *pcount, uint *tcount)
+{
+  if(r == 0){
+    (*pcount)++;
+    (*tcount)++;
+  }
+  return r;
+}
+
+// Handle a page fault of the current process at va with error
+// code err: a write to a copy-on-write page, a touch of a page
+// in swap, or the first touch of a program page exec did not load
+// or of a heap page.
+// Returns 0 if the access can be retried, -1 if it is a real fault.
+int
+pagefault(uint va, uint err)
+{
+  struct proc *p = myproc();
+  struct thread *t;
+  struct execseg *s;
+  pte_t *pte;
+
+  if(p == 0 || va >= KERNBASE)
+    return -1;
+  t = mythread();
+  if(err & FEC_P){
+    if(!(err & FEC_WR))
+      return -1;
+    return counted(cowfault(p->pgdir, va), &p->faults.cow, &t->faults.cow);
+  }
+  if(va >= p->sz)
+    return -1;
+  if((pte = walkpgdir(p->pgdir, (char*)va, 0)) != 0 && (*pte & PTE_SWAP))
+    return counted(swapin(p->pgdir, va), &p->faults.swapin, &t->faults.swapin);
+  for(s = p->seg; s < &p->seg[p->nseg]; s++)
+    if(va >= s->vaddr && PGROUNDDOWN(va) < s->vaddr + s->filesz)
+      return counted(execfault(p, s, va), &p->faults.exec, &t->faults.exec);
+  return counted(lazyfault(p, va), &p->faults.lazy, &t->faults.lazy);
+}
+
+// Map the pages of [va, va+n) of the current process before the
+// kernel touches them in a system call, where a fault it cannot
+// resolve (memlim, out of memory) would be a kernel panic.
+// Returns 0, or -1 if a page cannot be mapped.
+int
+uvmtouch(uint va, uint n)
+{
+  pte_t *pte;
+  uint a;
+
+  for(a = PGROUNDDOWN(va); a < va + n; a += PGSIZE){
+    pte = walkpgdir(myproc()->pgdir, (char*)a, 0);
+    if(pte && (*pte & PTE_P))
+      continue;
+    if(pagefault(a, 0) < 0)
+      return -1;
+  }
+  return 0;
+}
+
+// Number of pages mapped or swapped out in [lo, hi) of pgdir.
+int
+uvmresident(pde_t *pgdir, uint lo, uint hi)
+{
+  pte_t *pte;
+  uint a;
+  int n = 0;
+
+  for(a = PGROUNDUP(lo); a < hi; a += PGSIZE){
+    pte = walkpgdir(pgdir, (char*)a, 0);
+    if(!pte)
+      a = PGADDR(PDX(a) + 1, 0, 0) - PGSIZE;
+    else if(*pte & (PTE_P|PTE_SWAP))
+      n++;
+  }
+  return n;
+}
+
+// Memory of pgdir for getprocstat(), in pages: user pages below
+// sz that are mapped, how many of those are shared with another
+// page table or the page cache, pages in swap, and page-table
+// pages, the page directory included.
+void
+uvmstat(pde_t *pgdir, uint sz, struct procstat *ps)
+{
+  pte_t *pte;
+  char *v;
+  uint a;
+  int i;
+
+  ps->resident = ps->shared = ps->swapped = 0;
+  ps->ptpages = 1;
+  for(i = 0; i < NPDENTRIES; i++)
+    if(pgdir[i] & PTE_P)
+      ps->ptpages++;
+  acquire(&pflock);
+  for(a = 0; a < sz; a += PGSIZE){
+    pte = walkpgdir(pgdir, (char*)a, 0);
+    if(!pte){
+      a = PGADDR(PDX(a) + 1, 0, 0) - PGSIZE;
+      continue;
+    }
+    if(*pte & PTE_SWAP)
+      ps->swapped++;
+    else if(*pte & PTE_P){
+      ps->resident++;
+      v = P2V(PTE_ADDR(*pte));
+      if(krefs(v) > 1 || pccached(v))
+        ps->shared++;
+    }
+  }
+  release(&pflock);
+}
+
+// Clock step for swapout() over the pages of p, from *va up to
+// p->sz: a page accessed since the last visit gets a second chance
+// (its PTE_A is cleared); the first one that was not, and that no
+// other page table or the page cache shares, moves to swap slot
+// slot and is returned. *va is left after the pages visited.
+// Caller holds ptable.lock and has checked that p is not running.
+char*
+uvmevict(struct proc *p, uint *va, uint slot)
+{
+  pte_t *pte;
+  char *v;
+  uint a;
+
+  acquire(&pflock);
+  for(a = *va; a < p->sz; a += PGSIZE){
+    pte = walkpgdir(p->pgdir, (char*)a, 0);
+    if(!pte){
+      a = PGADDR(PDX(a) + 1, 0, 0) - PGSIZE;
+      continue;
+    }
+    if((*pte & (PTE_P|PTE_U)) != (PTE_P|PTE_U))
+      continue;
+    if(*pte & PTE_A){
+      *pte &= ~PTE_A;
+      continue;
+    }
+    v = P2V(PTE_ADDR(*pte));
+    if(krefs(v) != 1 || pccached(v))
+      continue;
+    *pte = (slot << PTXSHIFT) | PTE_SWAP |
+           (PTE_FLAGS(*pte) & (PTE_W|PTE_U|PTE_COW));
+    *va = a + PGSIZE;
+    release(&pflock);
+    return v;
+  }
+  *va = a;
+  release(&pflock);
+  return 0;
+}
+
+// Read the page at va of pgdir back from swap.
+// Returns 0, or -1 if there is no memory for it or the fault
+// came from code that cannot sleep.
+int
+swapin(pde_t *pgdir, uint va)
+{
+  pte_t *pte;
+  char *mem;
+  uint e;
+  int r = -1;
+
+  if(!(readeflags() & FL_IF))
+    return -1;
+  va = PGROUNDDOWN(va);
+  if((mem = ualloc()) == 0)
+    return -1;
+  // Holding swaplock() keeps the slot from being reused
+  // while it is read.
+  swaplock();
+  acquire(&pflock);
+  pte = walkpgdir(pgdir, (char*)va, 0);
+  e = pte ? *pte : 0;
+  release(&pflock);
+  if(!(e & PTE_SWAP)){
+    // Another thread read it in first.
+    swapunlock();
+    kfree(mem);
+    return (e & PTE_P) ? 0 : -1;
+  }
+  swapread(PTE_SLOT(e), mem);
+  acquire(&pflock);
+  if((pte = walkpgdir(pgdir, (char*)va, 0)) != 0 && *pte == e){
+    *pte = V2P(mem) | (PTE_FLAGS(e) & ~PTE_SWAP) | PTE_P;
+    mem = 0;
+    r = 0;
+  }
+  release(&pflock);
+  swapunlock();
+  if(mem)
+    kfree(mem);
+  else
+    swapfree(PTE_SLOT(e));
+  return r;
+}
+
 //PAGEBREAK!
 // Map user virtual address to kernel address.
 char*
@@ -351,7 +901,7 @@ uva2ka(pde_t *pgdir, char *uva)
   pte_t *pte;
 
   pte = walkpgdir(pgdir, uva, 0);
-  if((*pte & PTE_P) == 0)
+  if(pte == 0 || (*pte & PTE_P) == 0)
     return 0;
   if((*pte & PTE_U) == 0)
     return 0;
@@ -366,10 +916,16 @@ copyout(pde_t *pgdir, uint va, void *p, uint len)
 {
   char *buf, *pa0;
   uint n, va0;
+  pte_t *pte;
 
   buf = (char*)p;
   while(len > 0){
     va0 = (uint)PGROUNDDOWN(va);
+    // Writes through the kernel mapping do not fault,
+    // so break the sharing of a copy-on-write page here.
+    pte = walkpgdir(pgdir, (char*)va0, 0);
+    if(pte && (*pte & PTE_COW) && cowfault(pgdir, va0) < 0)
+      return -1;
     pa0 = uva2ka(pgdir, (char*)va0);
     if(pa0 == 0)
       return -1;
@@ -384,6 +940,34 @@ copyout(pde_t *pgdir, uint va, void *p, uint len)
   return 0;
 }
 
+// Zero n bytes of user memory at va in pgdir, breaking
+// copy-on-write sharing like copyout().
+// Returns 0, or -1 if a page is not mapped.
+int
+uvmclear(pde_t *pgdir, uint va, uint n)
+{
+  char *pa0;
+  uint m, va0;
+  pte_t *pte;
+
+  while(n > 0){
+    va0 = (uint)PGROUNDDOWN(va);
+    pte = walkpgdir(pgdir, (char*)va0, 0);
+    if(pte && (*pte & PTE_COW) && cowfault(pgdir, va0) < 0)
+      return -1;
+    pa0 = uva2ka(pgdir, (char*)va0);
+    if(pa0 == 0)
+      return -1;
+    m = PGSIZE - (va - va0);
+    if(m > n)
+      m = n;
+    memset(pa0 + (va - va0), 0, m);
+    n -= m;
+    va = va0 + PGSIZE;
+  }
+  return 0;
+}
+
 //PAGEBREAK!
 // Blank page.
 //PAGEBREAK!
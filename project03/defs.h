@@ -66,8 +66,12 @@ void            ioapicinit(void);
 // kalloc.c
 char*           kalloc(void);
 void            kfree(char*);
+void            kref(char*);
+int             krefs(char*);
 void            kinit1(void*, void*);
 void            kinit2(void*, void*);
+char*           kallochuge(void);
+void            kfreehuge(char*);
 
 // kbd.c
 void            kbdintr(void);
@@ -97,6 +101,16 @@ void            mpinit(void);
 void            picenable(int);
 void            picinit(void);
 
+// mmap.c
+void            mmapinit(void);
+int             mmap(struct file*, int, int, int, int);
+int             munmap(uint, int);
+int             mmapfault(uint, uint);
+int             mmaptouch(uint, uint, int);
+int             mmapused(struct proc*, uint, uint);
+int             mmapcopy(struct proc*, struct proc*);
+void            mmapclear(struct proc*, pde_t*);
+
 // pipe.c
 int             pipealloc(struct file**, struct file**);
 void            pipeclose(struct pipe*, int);
@@ -153,6 +167,7 @@ char*           strncpy(char*, const char*, int);
 // syscall.c
 int             argint(int, int*);
 int             argptr(int, char**, int);
+int             argwptr(int, char**, int);
 int             argstr(int, char**);
 int             fetchint(uint, int*);
 int             fetchstr(uint, char**);
@@ -187,6 +202,8 @@ void            switchuvm(struct proc*);
 void            switchkvm(void);
 int             copyout(pde_t*, uint, void*, uint);
 void            clearpteu(pde_t *pgdir, char *uva);
+uint*           walkpgdir(pde_t*, const void*, int);
+int             mappages(pde_t*, void*, uint, uint, int);
 
 // number of elements in fixed-size array
 #define NELEM(x) (sizeof(x)/sizeof((x)[0]))
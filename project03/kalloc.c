@@ -21,6 +21,8 @@ struct {
   struct spinlock lock;
   int use_lock;
   struct run *freelist;
+  struct run *hugelist;        // Free 4MiB pages, for MAP_HUGE
+  ushort ref[PHYSTOP / PGSIZE]; // Mappings of each page in use
 } kmem;
 
 // Initialization happens in two phases.
@@ -36,10 +38,20 @@ kinit1(void *vstart, void *vend)
   freerange(vstart, vend);
 }
 
+// kinit2() sets the top NHUGEPG 4MiB-aligned pages of the range
+// aside for kallochuge(), since kalloc() never gives out
+// contiguous memory.
 void
 kinit2(void *vstart, void *vend)
 {
-  freerange(vstart, vend);
+  char *p;
+
+  p = (char*)HUGEPGROUNDDOWN((uint)vend) - NHUGEPG*HUGEPGSIZE;
+  if(p < (char*)vstart)
+    panic("kinit2: no room for huge pages");
+  freerange(vstart, p);
+  for(; p + HUGEPGSIZE <= (char*)vend; p += HUGEPGSIZE)
+    kfreehuge(p);
   kmem.use_lock = 1;
 }
 
@@ -51,6 +63,26 @@ freerange(void *vstart, void *vend)
   for(; p + PGSIZE <= (char*)vend; p += PGSIZE)
     kfree(p);
 }
+
+// Drop a reference to page v, which may be a 4MiB page, and
+// return how many are left. A page shared by MAP_SHARED mappings
+// is freed by the last of them. Pages freed at boot have none.
+static int
+kunref(char *v)
+{
+  int n;
+
+  if(kmem.use_lock)
+    acquire(&kmem.lock);
+  n = kmem.ref[V2P(v) / PGSIZE];
+  if(n > 0)
+    n--;
+  kmem.ref[V2P(v) / PGSIZE] = n;
+  if(kmem.use_lock)
+    release(&kmem.lock);
+  return n;
+}
+
 //PAGEBREAK: 21
 // Free the page of physical memory pointed at by v,
 // which normally should have been returned by a
@@ -63,6 +95,8 @@ kfree(char *v)
 
   if((uint)v % PGSIZE || v < end || V2P(v) >= PHYSTOP)
     panic("kfree");
+  if(kunref(v) != 0)
+    return;
 
   // Fill with junk to catch dangling refs.
   memset(v, 1, PGSIZE);
@@ -87,10 +121,68 @@ kalloc(void)
   if(kmem.use_lock)
     acquire(&kmem.lock);
   r = kmem.freelist;
-  if(r)
+  if(r){
     kmem.freelist = r->next;
+    kmem.ref[V2P(r) / PGSIZE] = 1;
+  }
   if(kmem.use_lock)
     release(&kmem.lock);
   return (char*)r;
 }
 
+// Take another reference to page v, which may be a 4MiB page,
+// for a mapping that shares it.
+void
+kref(char *v)
+{
+  acquire(&kmem.lock);
+  if(kmem.ref[V2P(v) / PGSIZE] == 0)
+    panic("kref");
+  kmem.ref[V2P(v) / PGSIZE]++;
+  release(&kmem.lock);
+}
+
+// Number of references to page v.
+int
+krefs(char *v)
+{
+  return kmem.ref[V2P(v) / PGSIZE];
+}
+
+
+// Free a 4MiB page returned by kallochuge().
+void
+kfreehuge(char *v)
+{
+  struct run *r;
+
+  if((uint)v % HUGEPGSIZE || v < end || V2P(v) >= PHYSTOP)
+    panic("kfreehuge");
+  if(kunref(v) != 0)
+    return;
+
+  if(kmem.use_lock)
+    acquire(&kmem.lock);
+  r = (struct run*)v;
+  r->next = kmem.hugelist;
+  kmem.hugelist = r;
+  if(kmem.use_lock)
+    release(&kmem.lock);
+}
+
+// Allocate one physically contiguous 4MiB page, for a PTE_PS
+// mapping. Returns 0 if none is left.
+char*
+kallochuge(void)
+{
+  struct run *r;
+
+  acquire(&kmem.lock);
+  r = kmem.hugelist;
+  if(r){
+    kmem.hugelist = r->next;
+    kmem.ref[V2P(r) / PGSIZE] = 1;
+  }
+  release(&kmem.lock);
+  return (char*)r;
+}
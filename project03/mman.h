@@ -0,0 +1,11 @@
+// mmap() protections
+#define PROT_READ      0x1
+#define PROT_WRITE     0x2
+
+// mmap() flags
+#define MAP_SHARED     0x01   // Share pages and changes with the file
+#define MAP_PRIVATE    0x02   // Keep changes to this process
+#define MAP_ANONYMOUS  0x20   // Zero-filled memory, no file
+#define MAP_HUGE       0x40   // Use 4MiB pages (anonymous only)
+
+#define MAP_FAILED     ((void*)-1)
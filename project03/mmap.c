@@ -0,0 +1,576 @@
+// Memory mappings: mmap() and munmap().
+//
+// Each process has a small table of mappings (p->vma), placed
+// top-down from MMAPTOP, above the heap. Pages are not read when
+// a mapping is made: the first touch faults, and mmapfault() fills
+// the page from the file (through bmap(), so any file size works)
+// or with zeros. After that the program reads the file in place,
+// with no read() copying it into a buffer.
+//
+// Every MAP_SHARED mapping of a page of a file uses the same
+// physical page, found in the shared table below, so a write
+// through one mapping is seen at once by all of them. Fork gives
+// the child the same pages of a MAP_SHARED mapping, anonymous
+// ones too. kref() counts the mappings of a page; the last one
+// to unmap it writes it back to the file if any of them wrote
+// to it, so read() sees the changes from then on (and write()
+// does not reach a page while it is mapped). A MAP_PRIVATE
+// mapping has its own copy of each page and never writes back.
+//
+// An anonymous MAP_HUGE mapping is 4MiB-aligned and is backed by
+// 4MiB pages from kallochuge(), mapped by PTE_PS directory
+// entries: one TLB entry and no page table per 4MiB.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "x86.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "fs.h"
+#include "sleeplock.h"
+#include "file.h"
+#include "mman.h"
+
+#define NSHHASH 256
+#define SHHASH(ip, off) (((ip)->inum + (off) / PGSIZE) % NSHHASH)
+
+// A page of a file in use by MAP_SHARED mappings. Each mapping
+// that has it in its page table holds a kref() on mem.
+struct shpage {
+  struct inode *ip;     // 0 if the entry is free
+  uint off;             // Offset of the page in the file
+  char *mem;
+  int dirty;            // Written by a mapping now gone
+  struct shpage *next;  // Hash chain, or free list
+};
+
+struct {
+  struct spinlock lock;
+  struct shpage page[NSHPAGE];
+  struct shpage *hash[NSHHASH];
+  struct shpage *free;
+} shared;
+
+void
+mmapinit(void)
+{
+  struct shpage *s;
+
+  initlock(&shared.lock, "shared");
+  for(s = shared.page; s < &shared.page[NSHPAGE]; s++){
+    s->next = shared.free;
+    shared.free = s;
+  }
+}
+
+// The link to the entry for page off of ip, which points to 0
+// if there is none. Caller holds shared.lock.
+static struct shpage**
+shlookup(struct inode *ip, uint off)
+{
+  struct shpage **pp;
+
+  for(pp = &shared.hash[SHHASH(ip, off)]; *pp != 0; pp = &(*pp)->next)
+    if((*pp)->ip == ip && (*pp)->off == off)
+      break;
+  return pp;
+}
+
+// The mapping of p that contains va, or 0.
+static struct vma*
+findvma(struct proc *p, uint va)
+{
+  struct vma *v;
+
+  for(v = p->vma; v < &p->vma[NVMA]; v++)
+    if(v->len != 0 && va >= v->start && va < v->start + v->len)
+      return v;
+  return 0;
+}
+
+// Does any mapping of p overlap [start, end)?
+int
+mmapused(struct proc *p, uint start, uint end)
+{
+  struct vma *v;
+
+  for(v = p->vma; v < &p->vma[NVMA]; v++)
+    if(v->len != 0 && start < v->start + v->len && v->start < end)
+      return 1;
+  return 0;
+}
+
+// Highest free range of len bytes below MMAPTOP and above the
+// heap, starting at a multiple of align, or 0.
+static uint
+mmapaddr(struct proc *p, uint len, uint align)
+{
+  struct vma *v;
+  uint a;
+
+  if(len > MMAPTOP)
+    return 0;
+  a = MMAPTOP - len;
+  for(;;){
+    if(a < PGROUNDUP(p->sz))
+      return 0;
+    for(v = p->vma; v < &p->vma[NVMA]; v++)
+      if(v->len != 0 && a < v->start + v->len && v->start < a + len)
+        break;
+    if(v == &p->vma[NVMA])
+      return a;
+    if(v->start < len)
+      return 0;
+    a = (v->start - len) & ~(align - 1);
+  }
+}
+
+// Map len bytes of f from offset off, or anonymous memory if f
+// is 0. Returns the address, or -1.
+int
+mmap(struct file *f, int len, int prot, int flags, int off)
+{
+  struct proc *p = myproc();
+  struct vma *v;
+  uint a;
+
+  if(len <= 0 || off < 0 || off % PGSIZE != 0)
+    return -1;
+  if(!(flags & MAP_SHARED) == !(flags & MAP_PRIVATE))
+    return -1;
+  if((flags & MAP_HUGE) && f)
+    return -1;
+  if(f){
+    if(f->type != FD_INODE || !f->readable)
+      return -1;
+    if((flags & MAP_SHARED) && (prot & PROT_WRITE) && !f->writable)
+      return -1;
+  }
+
+  for(v = p->vma; v < &p->vma[NVMA]; v++)
+    if(v->len == 0)
+      break;
+  if(v == &p->vma[NVMA])
+    return -1;
+  if(flags & MAP_HUGE){
+    len = HUGEPGROUNDUP(len);
+    a = mmapaddr(p, len, HUGEPGSIZE);
+  } else {
+    len = PGROUNDUP(len);
+    a = mmapaddr(p, len, PGSIZE);
+  }
+  if(a == 0)
+    return -1;
+
+  v->start = a;
+  v->len = len;
+  v->prot = prot;
+  v->flags = flags;
+  v->f = f ? filedup(f) : 0;
+  v->off = off;
+  return a;
+}
+
+// Is va mapped in pgdir, by a page or a 4MiB page?
+static int
+present(pde_t *pgdir, uint va)
+{
+  pte_t *pte;
+
+  if((pgdir[PDX(va)] & (PTE_P|PTE_PS)) == (PTE_P|PTE_PS))
+    return 1;
+  pte = walkpgdir(pgdir, (char*)va, 0);
+  return pte != 0 && (*pte & PTE_P);
+}
+
+// Map a zeroed 4MiB page at va, of MAP_HUGE mapping v.
+static int
+hugefill(struct proc *p, struct vma *v, uint va)
+{
+  pde_t *pde;
+  char *mem;
+
+  if((mem = kallochuge()) == 0)
+    return -1;
+  memset(mem, 0, HUGEPGSIZE);
+  pde = &p->pgdir[PDX(va)];
+  // A page table left from earlier mappings here is empty.
+  if(*pde & PTE_P)
+    kfree(P2V(PTE_ADDR(*pde)));
+  *pde = V2P(mem) | PTE_P | PTE_U | PTE_PS;
+  if(v->prot & PROT_WRITE)
+    *pde |= PTE_W;
+  return 0;
+}
+
+// Write the page of v at va back to the file. The file does not
+// grow: bytes mapped past its end are dropped. A page is 8 blocks,
+// which fit in one transaction since no block is allocated.
+static void
+writeback(struct vma *v, uint va, char *mem)
+{
+  struct inode *ip = v->f->ip;
+  uint off, n;
+
+  off = v->off + (va - v->start);
+  begin_op();
+  ilock(ip);
+  if(off < ip->size){
+    n = ip->size - off;
+    if(n > PGSIZE)
+      n = PGSIZE;
+    writei(ip, mem, off, n);
+  }
+  iunlock(ip);
+  end_op();
+}
+
+// A new page holding the page of v at va, or zeros.
+static char*
+readpage(struct vma *v, uint va)
+{
+  char *mem;
+
+  if((mem = kalloc()) == 0)
+    return 0;
+  memset(mem, 0, PGSIZE);
+  if(v->f){
+    // Past the end of the file the page stays zero.
+    ilock(v->f->ip);
+    readi(v->f->ip, mem, v->off + (va - v->start), PGSIZE);
+    iunlock(v->f->ip);
+  }
+  return mem;
+}
+
+// The page of shared file mapping v at va, read from the file
+// unless some mapping has it already. Takes a reference for the
+// caller. Returns 0 if out of memory or table entries.
+static char*
+shget(struct vma *v, uint va)
+{
+  struct inode *ip = v->f->ip;
+  uint off = v->off + (va - v->start);
+  struct shpage *s;
+  char *mem;
+
+  acquire(&shared.lock);
+  if((s = *shlookup(ip, off)) != 0){
+    kref(s->mem);
+    release(&shared.lock);
+    return s->mem;
+  }
+  release(&shared.lock);
+
+  if((mem = readpage(v, va)) == 0)
+    return 0;
+  acquire(&shared.lock);
+  // Another process may have read it while this one slept.
+  if((s = *shlookup(ip, off)) != 0){
+    kref(s->mem);
+    release(&shared.lock);
+    kfree(mem);
+    return s->mem;
+  }
+  if((s = shared.free) == 0){
+    release(&shared.lock);
+    kfree(mem);
+    return 0;
+  }
+  shared.free = s->next;
+  s->ip = ip;
+  s->off = off;
+  s->mem = mem;
+  s->dirty = 0;
+  s->next = shared.hash[SHHASH(ip, off)];
+  shared.hash[SHHASH(ip, off)] = s;
+  release(&shared.lock);
+  return mem;
+}
+
+// Drop a reference to page mem of shared file mapping v at va,
+// which the mapping wrote to if dirty is set. The last mapping
+// writes the page back if any of them wrote to it. The entry
+// stays while it does, so that a mapping made meanwhile finds
+// the page rather than the old data in the file.
+static void
+shput(struct vma *v, uint va, char *mem, int dirty)
+{
+  struct inode *ip = v->f->ip;
+  uint off = v->off + (va - v->start);
+  struct shpage *s;
+
+  acquire(&shared.lock);
+  if((s = *shlookup(ip, off)) == 0 || s->mem != mem)
+    panic("shput");
+  if(dirty)
+    s->dirty = 1;
+  while(krefs(mem) == 1 && s->dirty){
+    s->dirty = 0;
+    release(&shared.lock);
+    writeback(v, va, mem);
+    acquire(&shared.lock);
+  }
+  if(krefs(mem) == 1){
+    *shlookup(ip, off) = s->next;
+    s->ip = 0;
+    s->next = shared.free;
+    shared.free = s;
+  }
+  release(&shared.lock);
+  kfree(mem);
+}
+
+// Read the page of v at va, or zero it, and map it.
+static int
+mmapfill(struct proc *p, struct vma *v, uint va)
+{
+  char *mem;
+  int perm;
+
+  if(v->flags & MAP_HUGE)
+    return hugefill(p, v, HUGEPGROUNDDOWN(va));
+  if(v->f && (v->flags & MAP_SHARED))
+    mem = shget(v, va);
+  else
+    mem = readpage(v, va);
+  if(mem == 0)
+    return -1;
+  perm = PTE_U;
+  if(v->prot & PROT_WRITE)
+    perm |= PTE_W;
+  if(mappages(p->pgdir, (char*)va, PGSIZE, V2P(mem), perm) < 0){
+    if(v->f && (v->flags & MAP_SHARED))
+      shput(v, va, mem, 0);
+    else
+      kfree(mem);
+    return -1;
+  }
+  return 0;
+}
+
+// Handle a page fault at va from user space.
+// Returns 0 if it was for a page of a mapping that may be
+// accessed this way, else -1.
+int
+mmapfault(uint va, uint err)
+{
+  struct proc *p = myproc();
+  struct vma *v;
+
+  if((v = findvma(p, va)) == 0)
+    return -1;
+  if((err & FEC_WR) && !(v->prot & PROT_WRITE))
+    return -1;
+  va = PGROUNDDOWN(va);
+  if(present(p->pgdir, va))
+    return -1;
+  return mmapfill(p, v, va);
+}
+
+// Fault in the pages of [va, va+n), which must lie in mappings,
+// so that a system call can use them as a buffer. If write is
+// set, the mappings must also allow writing.
+int
+mmaptouch(uint va, uint n, int write)
+{
+  struct proc *p = myproc();
+  struct vma *v;
+  uint a;
+
+  if(va + n < va)
+    return -1;
+  for(a = PGROUNDDOWN(va); a < va + n; a += PGSIZE){
+    if((v = findvma(p, a)) == 0)
+      return -1;
+    if(write && !(v->prot & PROT_WRITE))
+      return -1;
+    if(present(p->pgdir, a))
+      continue;
+    if(mmapfill(p, v, a) < 0)
+      return -1;
+  }
+  return 0;
+}
+
+// Unmap the pages of v in [start, end) from pgdir, dropping
+// its references to shared ones.
+static void
+vmaunmap(pde_t *pgdir, struct vma *v, uint start, uint end)
+{
+  pde_t *pde;
+  pte_t *pte;
+  char *mem;
+  uint a, dirty;
+
+  if(v->flags & MAP_HUGE){
+    for(a = start; a < end; a += HUGEPGSIZE){
+      pde = &pgdir[PDX(a)];
+      if((*pde & (PTE_P|PTE_PS)) == (PTE_P|PTE_PS)){
+        kfreehuge(P2V(PTE_ADDR(*pde)));
+        *pde = 0;
+      }
+    }
+    return;
+  }
+  for(a = start; a < end; a += PGSIZE){
+    if((pte = walkpgdir(pgdir, (char*)a, 0)) == 0 || !(*pte & PTE_P))
+      continue;
+    mem = P2V(PTE_ADDR(*pte));
+    dirty = *pte & PTE_D;
+    *pte = 0;
+    if(v->f && (v->flags & MAP_SHARED))
+      shput(v, a, mem, dirty);
+    else
+      kfree(mem);
+  }
+}
+
+// Unmap [addr, addr+len). Mappings that only partly overlap the
+// range keep the rest; one that contains it is split in two.
+int
+munmap(uint addr, int len)
+{
+  struct proc *p = myproc();
+  struct vma *v, *nv;
+  uint end, start, vend;
+
+  if(len <= 0 || addr % PGSIZE != 0)
+    return -1;
+  end = addr + PGROUNDUP(len);
+  if(end < addr || end > MMAPTOP)
+    return -1;
+  // 4MiB pages are not split.
+  if(addr % HUGEPGSIZE != 0 || end % HUGEPGSIZE != 0)
+    for(v = p->vma; v < &p->vma[NVMA]; v++)
+      if(v->len != 0 && (v->flags & MAP_HUGE) &&
+         addr < v->start + v->len && v->start < end)
+        return -1;
+
+  for(v = p->vma; v < &p->vma[NVMA]; v++){
+    if(v->len == 0 || addr >= v->start + v->len || v->start >= end)
+      continue;
+    vend = v->start + v->len;
+    start = addr > v->start ? addr : v->start;
+    if(start > v->start && end < vend){
+      // Split: the part above the hole moves to a new slot.
+      for(nv = p->vma; nv < &p->vma[NVMA]; nv++)
+        if(nv->len == 0)
+          break;
+      if(nv == &p->vma[NVMA])
+        return -1;
+      *nv = *v;
+      nv->start = end;
+      nv->len = vend - end;
+      nv->off = v->off + (end - v->start);
+      if(nv->f)
+        filedup(nv->f);
+      vmaunmap(p->pgdir, v, start, end);
+      v->len = start - v->start;
+    } else if(start > v->start){
+      vmaunmap(p->pgdir, v, start, vend);
+      v->len = start - v->start;
+    } else if(end < vend){
+      vmaunmap(p->pgdir, v, v->start, end);
+      v->off += end - v->start;
+      v->len = vend - end;
+      v->start = end;
+    } else {
+      vmaunmap(p->pgdir, v, v->start, vend);
+      if(v->f)
+        fileclose(v->f);
+      v->f = 0;
+      v->len = 0;
+    }
+  }
+  lcr3(V2P(p->pgdir));
+  return 0;
+}
+
+// Give np p's mappings and the pages already faulted in: the
+// same pages for MAP_SHARED mappings, copies for MAP_PRIVATE
+// ones. Returns -1, with np left without mappings, if memory
+// runs out; the caller frees np->pgdir.
+int
+mmapcopy(struct proc *np, struct proc *p)
+{
+  struct vma *v, *nv;
+  pde_t pde;
+  pte_t *pte;
+  char *mem;
+  uint a;
+
+  for(v = p->vma, nv = np->vma; v < &p->vma[NVMA]; v++, nv++){
+    if(v->len == 0)
+      continue;
+    *nv = *v;
+    if(nv->f)
+      filedup(nv->f);
+    if(v->flags & MAP_HUGE){
+      for(a = v->start; a < v->start + v->len; a += HUGEPGSIZE){
+        pde = p->pgdir[PDX(a)];
+        if((pde & (PTE_P|PTE_PS)) != (PTE_P|PTE_PS))
+          continue;
+        if(v->flags & MAP_SHARED){
+          mem = P2V(PTE_ADDR(pde));
+          kref(mem);
+        } else {
+          if((mem = kallochuge()) == 0)
+            goto bad;
+          memmove(mem, P2V(PTE_ADDR(pde)), HUGEPGSIZE);
+        }
+        np->pgdir[PDX(a)] = V2P(mem) | PTE_FLAGS(pde);
+      }
+      continue;
+    }
+    for(a = v->start; a < v->start + v->len; a += PGSIZE){
+      if((pte = walkpgdir(p->pgdir, (char*)a, 0)) == 0 || !(*pte & PTE_P))
+        continue;
+      if(v->flags & MAP_SHARED){
+        // p keeps its reference, so this kfree() on failure
+        // never frees the page.
+        mem = P2V(PTE_ADDR(*pte));
+        kref(mem);
+      } else {
+        if((mem = kalloc()) == 0)
+          goto bad;
+        memmove(mem, P2V(PTE_ADDR(*pte)), PGSIZE);
+      }
+      if(mappages(np->pgdir, (char*)a, PGSIZE, V2P(mem),
+                  PTE_FLAGS(*pte) & (PTE_W|PTE_U)) < 0){
+        kfree(mem);
+        goto bad;
+      }
+    }
+  }
+  return 0;
+
+bad:
+  for(nv = np->vma; nv < &np->vma[NVMA]; nv++){
+    if(nv->len != 0 && nv->f)
+      fileclose(nv->f);
+    nv->f = 0;
+    nv->len = 0;
+  }
+  return -1;
+}
+
+// Drop all mappings of p, whose pages are in pgdir. Called by exit, and by exec for the old image.
+void
+mmapclear(struct proc *p, pde_t *pgdir)
+{
+  struct vma *v;
+
+  for(v = p->vma; v < &p->vma[NVMA]; v++){
+    if(v->len == 0)
+      continue;
+    vmaunmap(pgdir, v, v->start, v->start + v->len);
+    if(v->f)
+      fileclose(v->f);
+    v->f = 0;
+    v->len = 0;
+  }
+}
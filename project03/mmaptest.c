@@ -0,0 +1,259 @@
+#include "param.h"
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fcntl.h"
+#include "mman.h"
+
+// mmap test.
+// Writes a file that needs the double indirect blocks, then
+// checks private, shared and anonymous mappings, pages shared
+// between mappings and with a fork child, and mapped memory as
+// a system call buffer. Also compares the time
+// to scan the file through read() and through a mapping.
+
+#define FILESIZE (8 * 1024 * 1024)
+
+int stdout = 1;
+char buf[4096];
+char *path = "mmapfile";
+
+void
+fail(char *msg)
+{
+  printf(stdout, "[Error] %s\n", msg);
+  unlink(path);
+  exit();
+}
+
+// Byte i of the file.
+char
+pattern(int i)
+{
+  return (i / 512) % 26 + 'a';
+}
+
+void
+makefile(void)
+{
+  int fd, i, j;
+
+  fd = open(path, O_CREATE|O_RDWR);
+  if(fd < 0)
+    fail("create failed");
+  for(i = 0; i < FILESIZE; i += sizeof(buf)){
+    for(j = 0; j < sizeof(buf); j++)
+      buf[j] = pattern(i + j);
+    if(write(fd, buf, sizeof(buf)) != sizeof(buf))
+      fail("write failed");
+  }
+  close(fd);
+}
+
+char*
+mapfile(int omode, int prot, int flags)
+{
+  char *p;
+  int fd;
+
+  if((fd = open(path, omode)) < 0)
+    fail("open failed");
+  p = mmap(0, FILESIZE, prot, flags, fd, 0);
+  close(fd);
+  if(p == MAP_FAILED)
+    fail("mmap failed");
+  return p;
+}
+
+void
+scantest(void)
+{
+  char *p;
+  int fd, i, n, sum, start, tread, tmap;
+
+  start = uptime();
+  if((fd = open(path, O_RDONLY)) < 0)
+    fail("open failed");
+  sum = 0;
+  while((n = read(fd, buf, sizeof(buf))) > 0)
+    for(i = 0; i < n; i += 512)
+      sum += buf[i];
+  close(fd);
+  tread = uptime() - start;
+
+  start = uptime();
+  p = mapfile(O_RDONLY, PROT_READ, MAP_PRIVATE);
+  for(i = 0; i < FILESIZE; i += 512){
+    if(p[i] != pattern(i))
+      fail("mapped file differs");
+    sum -= p[i];
+  }
+  tmap = uptime() - start;
+  if(sum != 0)
+    fail("read and mapping differ");
+  if(munmap(p, FILESIZE) < 0)
+    fail("munmap failed");
+  printf(stdout, "scan %d MiB: read %d ticks, mmap %d ticks\n",
+         FILESIZE / (1024 * 1024), tread, tmap);
+}
+
+// Byte off of the file, through read().
+char
+fileat(int off)
+{
+  int fd;
+
+  if((fd = open(path, O_RDONLY)) < 0)
+    fail("open failed");
+  while(off >= sizeof(buf)){
+    read(fd, buf, sizeof(buf));
+    off -= sizeof(buf);
+  }
+  read(fd, buf, off + 1);
+  close(fd);
+  return buf[off];
+}
+
+void
+privatetest(void)
+{
+  char *p;
+
+  p = mapfile(O_RDONLY, PROT_READ|PROT_WRITE, MAP_PRIVATE);
+  p[0] = 'X';
+  if(munmap(p, FILESIZE) < 0)
+    fail("munmap failed");
+  if(fileat(0) != pattern(0))
+    fail("private write reached the file");
+  printf(stdout, "private mapping ok\n");
+}
+
+void
+sharedtest(void)
+{
+  char *p;
+  int off;
+
+  off = 5 * 1024 * 1024 + 100;
+  p = mapfile(O_RDWR, PROT_READ|PROT_WRITE, MAP_SHARED);
+  p[off] = 'Y';
+  // Unmap the middle page only; the rest stays mapped.
+  if(munmap(p + (off & ~4095), 4096) < 0)
+    fail("munmap failed");
+  if(fileat(off) != 'Y')
+    fail("shared write was not written back");
+  if(p[0] != pattern(0) || p[FILESIZE - 1] != pattern(FILESIZE - 1))
+    fail("rest of the mapping lost");
+  if(munmap(p, FILESIZE) < 0)
+    fail("munmap failed");
+  printf(stdout, "shared mapping ok\n");
+}
+
+// A write through one MAP_SHARED mapping shows at once in the
+// others of the same page, the fork child's included.
+void
+sharingtest(void)
+{
+  char *p, *q, *a;
+
+  p = mapfile(O_RDWR, PROT_READ|PROT_WRITE, MAP_SHARED);
+  q = mapfile(O_RDONLY, PROT_READ, MAP_SHARED);
+  if(q[4096] != pattern(4096) || q[8192] != pattern(8192))
+    fail("shared mapping read wrong data");
+  p[4096] = 'Z';
+  if(q[4096] != 'Z')
+    fail("write not seen by another shared mapping");
+  a = mmap(0, 4096, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_ANONYMOUS, -1, 0);
+  if(a == MAP_FAILED)
+    fail("anonymous mmap failed");
+  a[0] = 'a';
+  if(fork() == 0){
+    p[8192] = 'W';
+    a[0] = 'V';
+    exit();
+  }
+  wait();
+  if(q[8192] != 'W')
+    fail("child's write to a shared file mapping not seen");
+  if(a[0] != 'V')
+    fail("child's write to a shared anonymous mapping not seen");
+  if(munmap(p, FILESIZE) < 0 || munmap(q, FILESIZE) < 0)
+    fail("munmap failed");
+  if(fileat(4096) != 'Z' || fileat(8192) != 'W')
+    fail("shared writes were not written back");
+  munmap(a, 4096);
+  printf(stdout, "sharing ok\n");
+}
+
+// The kernel must refuse to write into a read-only mapping
+// rather than fault on it.
+void
+readonlytest(void)
+{
+  char *p;
+  int fd, pfd[2];
+
+  p = mapfile(O_RDONLY, PROT_READ, MAP_PRIVATE);
+  if((fd = open(path, O_RDONLY)) < 0)
+    fail("open failed");
+  if(read(fd, p, 100) >= 0)
+    fail("read into a read-only mapping");
+  if(read(fd, p + 3 * 4096, 100) >= 0)
+    fail("read into an untouched read-only page");
+  close(fd);
+  if(pipe((int*)p) >= 0)
+    fail("pipe into a read-only mapping");
+  // Reading from it is still fine.
+  if(pipe(pfd) < 0)
+    fail("pipe failed");
+  if(write(pfd[1], p, 100) != 100)
+    fail("write from a read-only mapping failed");
+  close(pfd[0]);
+  close(pfd[1]);
+  if(p[0] != pattern(0))
+    fail("read-only mapping changed");
+  if(munmap(p, FILESIZE) < 0)
+    fail("munmap failed");
+  printf(stdout, "read-only mapping ok\n");
+}
+
+void
+anontest(void)
+{
+  char *p;
+  int i;
+
+  p = mmap(0, 64 * 4096, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+  if(p == MAP_FAILED)
+    fail("anonymous mmap failed");
+  for(i = 0; i < 64 * 4096; i += 4096)
+    if(p[i] != 0)
+      fail("anonymous memory not zeroed");
+  strcpy(p, "anonymous");
+  if(fork() == 0){
+    if(strcmp(p, "anonymous") != 0)
+      fail("child lost the mapping");
+    // Mapped memory as a system call buffer.
+    if(write(stdout, p, 9) != 9)
+      fail("write from mapping failed");
+    printf(stdout, " mapping ok\n");
+    exit();
+  }
+  wait();
+  munmap(p, 64 * 4096);
+}
+
+int
+main(int argc, char *argv[])
+{
+  makefile();
+  scantest();
+  privatetest();
+  sharedtest();
+  sharingtest();
+  readonlytest();
+  anontest();
+  unlink(path);
+  printf(stdout, "All tests Passed\n");
+  exit();
+}
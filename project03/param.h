@@ -2,6 +2,9 @@
 #define KSTACKSIZE 4096  // size of per-process kernel stack
 #define NCPU          8  // maximum number of CPUs
 #define NOFILE       16  // open files per process
+#define NVMA         16  // memory mappings per process
+#define NHUGEPG       8  // 4MiB pages set aside for MAP_HUGE
+#define NSHPAGE    4096  // file pages in use by MAP_SHARED mappings
 #define NFILE       100  // open files per system
 #define NINODE       50  // maximum number of active i-nodes
 #define NDEV         10  // maximum major device number
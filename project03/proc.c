@@ -4,26 +4,55 @@
 #include "memlayout.h"
 #include "mmu.h"
 #include "x86.h"
-#include "proc.h"
 #include "spinlock.h"
+#include "proc.h"
 
+// ptable.lock protects p->parent and keeps wait() from
+// missing the wakeup of an exiting child. Process state is
+// protected by each p->lock (see proc.h).
 struct {
   struct spinlock lock;
   struct proc proc[NPROC];
 } ptable;
 
+// Wait channels
+// Sleeping processes are chained in a bucket chosen by hashing
+// their chan, so wakeup() only visits processes that may be
+// sleeping on it. Lock order: bucket lock, then p->lock.
+#define NSLEEPQ_SHIFT 6
+#define NSLEEPQ (1 << NSLEEPQ_SHIFT)
+
+struct sleepq {
+  struct spinlock lock;
+  struct proc *head;
+};
+
+struct sleepq sleepq[NSLEEPQ];
+
+// Bucket of the given wait channel
+static struct sleepq*
+sleepq_of(void *chan)
+{
+  return &sleepq[((uint)chan * 2654435761U) >> (32 - NSLEEPQ_SHIFT)];
+}
+
 static struct proc *initproc;
 
 int nextpid = 1;
 extern void forkret(void);
 extern void trapret(void);
 
-static void wakeup1(void *chan);
-
 void
 pinit(void)
 {
+  struct proc *p;
+  int i;
+
   initlock(&ptable.lock, "ptable");
+  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+    initlock(&p->lock, "proc");
+  for(i = 0; i < NSLEEPQ; i++)
+    initlock(&sleepq[i].lock, "sleepq");
 }
 
 // Must be called with interrupts disabled
@@ -76,24 +105,25 @@ allocproc(void)
   struct proc *p;
   char *sp;
 
-  acquire(&ptable.lock);
-
-  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
+    acquire(&p->lock);
     if(p->state == UNUSED)
       goto found;
-
-  release(&ptable.lock);
+    release(&p->lock);
+  }
   return 0;
 
 found:
   p->state = EMBRYO;
-  p->pid = nextpid++;
+  p->pid = __sync_fetch_and_add(&nextpid, 1);
 
-  release(&ptable.lock);
+  release(&p->lock);
 
   // Allocate kernel stack.
   if((p->kstack = kalloc()) == 0){
+    acquire(&p->lock);
     p->state = UNUSED;
+    release(&p->lock);
     return 0;
   }
   sp = p->kstack + KSTACKSIZE;
@@ -146,11 +176,11 @@ userinit(void)
   // run this process. the acquire forces the above
   // writes to be visible, and the lock is also needed
   // because the assignment might not be atomic.
-  acquire(&ptable.lock);
+  acquire(&p->lock);
 
   p->state = RUNNABLE;
 
-  release(&ptable.lock);
+  release(&p->lock);
 }
 
 // Grow current process's memory by n bytes.
@@ -163,6 +193,8 @@ growproc(int n)
 
   sz = curproc->sz;
   if(n > 0){
+    if(mmapused(curproc, sz, sz + n))
+      return -1;
     if((sz = allocuvm(curproc->pgdir, sz, sz + n)) == 0)
       return -1;
   } else if(n < 0){
@@ -193,11 +225,22 @@ fork(void)
   if((np->pgdir = copyuvm(curproc->pgdir, curproc->sz)) == 0){
     kfree(np->kstack);
     np->kstack = 0;
+    acquire(&np->lock);
     np->state = UNUSED;
+    release(&np->lock);
     return -1;
   }
   np->sz = curproc->sz;
-  np->parent = curproc;
+  if(mmapcopy(np, curproc) < 0){
+    freevm(np->pgdir);
+    np->pgdir = 0;
+    kfree(np->kstack);
+    np->kstack = 0;
+    acquire(&np->lock);
+    np->state = UNUSED;
+    release(&np->lock);
+    return -1;
+  }
   *np->tf = *curproc->tf;
 
   // Clear %eax so that fork returns 0 in the child.
@@ -213,10 +256,12 @@ fork(void)
   pid = np->pid;
 
   acquire(&ptable.lock);
+  np->parent = curproc;
+  release(&ptable.lock);
 
+  acquire(&np->lock);
   np->state = RUNNABLE;
-
-  release(&ptable.lock);
+  release(&np->lock);
 
   return pid;
 }
@@ -234,6 +279,9 @@ exit(void)
   if(curproc == initproc)
     panic("init exiting");
 
+  // Write back and drop memory mappings.
+  mmapclear(curproc, curproc->pgdir);
+
   // Close all open files.
   for(fd = 0; fd < NOFILE; fd++){
     if(curproc->ofile[fd]){
@@ -250,17 +298,21 @@ exit(void)
   acquire(&ptable.lock);
 
   // Parent might be sleeping in wait().
-  wakeup1(curproc->parent);
+  // It cannot see us before we are a zombie because
+  // it also holds ptable.lock while looking.
+  wakeup(curproc->parent);
 
   // Pass abandoned children to init.
   for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
     if(p->parent == curproc){
       p->parent = initproc;
-      if(p->state == ZOMBIE)
-        wakeup1(initproc);
+      wakeup(initproc);
     }
   }
 
+  acquire(&curproc->lock);
+  release(&ptable.lock);
+
   // Jump into the scheduler, never to return.
   curproc->state = ZOMBIE;
   sched();
@@ -284,6 +336,9 @@ wait(void)
       if(p->parent != curproc)
         continue;
       havekids = 1;
+      // Holding p->lock also waits for the scheduler to
+      // finish switching away from an exiting child.
+      acquire(&p->lock);
       if(p->state == ZOMBIE){
         // Found one.
         pid = p->pid;
@@ -295,9 +350,11 @@ wait(void)
         p->name[0] = 0;
         p->killed = 0;
         p->state = UNUSED;
+        release(&p->lock);
         release(&ptable.lock);
         return pid;
       }
+      release(&p->lock);
     }
 
     // No point waiting if we don't have any children.
@@ -306,7 +363,7 @@ wait(void)
       return -1;
     }
 
-    // Wait for children to exit.  (See wakeup1 call in proc_exit.)
+    // Wait for children to exit.  (See wakeup call in proc_exit.)
     sleep(curproc, &ptable.lock);  //DOC: wait-sleep
   }
 }
@@ -331,13 +388,17 @@ scheduler(void)
     sti();
 
     // Loop over process table looking for process to run.
-    acquire(&ptable.lock);
     for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
       if(p->state != RUNNABLE)
         continue;
+      acquire(&p->lock);
+      if(p->state != RUNNABLE){
+        release(&p->lock);
+        continue;
+      }
 
       // Switch to chosen process.  It is the process's job
-      // to release ptable.lock and then reacquire it
+      // to release p->lock and then reacquire it
       // before jumping back to us.
       c->proc = p;
       switchuvm(p);
@@ -349,13 +410,13 @@ scheduler(void)
       // Process is done running for now.
       // It should have changed its p->state before coming back.
       c->proc = 0;
+      release(&p->lock);
     }
-    release(&ptable.lock);
 
   }
 }
 
-// Enter scheduler.  Must hold only ptable.lock
+// Enter scheduler.  Must hold only p->lock
 // and have changed proc->state. Saves and restores
 // intena because intena is a property of this
 // kernel thread, not this CPU. It should
@@ -368,8 +429,8 @@ sched(void)
   int intena;
   struct proc *p = myproc();
 
-  if(!holding(&ptable.lock))
-    panic("sched ptable.lock");
+  if(!holding(&p->lock))
+    panic("sched p->lock");
   if(mycpu()->ncli != 1)
     panic("sched locks");
   if(p->state == RUNNING)
@@ -385,10 +446,12 @@ sched(void)
 void
 yield(void)
 {
-  acquire(&ptable.lock);  //DOC: yieldlock
-  myproc()->state = RUNNABLE;
+  struct proc *p = myproc();
+
+  acquire(&p->lock);  //DOC: yieldlock
+  p->state = RUNNABLE;
   sched();
-  release(&ptable.lock);
+  release(&p->lock);
 }
 
 // A fork child's very first scheduling by scheduler()
@@ -397,8 +460,8 @@ void
 forkret(void)
 {
   static int first = 1;
-  // Still holding ptable.lock from scheduler.
-  release(&ptable.lock);
+  // Still holding p->lock from scheduler.
+  release(&myproc()->lock);
 
   if (first) {
     // Some initialization functions must be run in the context
@@ -418,6 +481,7 @@ void
 sleep(void *chan, struct spinlock *lk)
 {
   struct proc *p = myproc();
+  struct sleepq *sq = sleepq_of(chan);
   
   if(p == 0)
     panic("sleep");
@@ -425,18 +489,20 @@ sleep(void *chan, struct spinlock *lk)
   if(lk == 0)
     panic("sleep without lk");
 
-  // Must acquire ptable.lock in order to
-  // change p->state and then call sched.
-  // Once we hold ptable.lock, we can be
-  // guaranteed that we won't miss any wakeup
-  // (wakeup runs with ptable.lock locked),
-  // so it's okay to release lk.
-  if(lk != &ptable.lock){  //DOC: sleeplock0
-    acquire(&ptable.lock);  //DOC: sleeplock1
-    release(lk);
-  }
-  // Go to sleep.
+  // Must join the bucket of chan and acquire p->lock
+  // before releasing lk. Once we are in the bucket
+  // holding p->lock, wakeup (which runs with the bucket
+  // lock held and then takes p->lock) can only find us
+  // after sched() is done, so it's okay to release lk.
+  acquire(&sq->lock);  //DOC: sleeplock1
   p->chan = chan;
+  p->sleepnext = sq->head;
+  sq->head = p;
+  acquire(&p->lock);
+  release(&sq->lock);
+  release(lk);
+
+  // Go to sleep.
   p->state = SLEEPING;
 
   sched();
@@ -445,32 +511,41 @@ sleep(void *chan, struct spinlock *lk)
   p->chan = 0;
 
   // Reacquire original lock.
-  if(lk != &ptable.lock){  //DOC: sleeplock2
-    release(&ptable.lock);
-    acquire(lk);
-  }
+  release(&p->lock);
+  acquire(lk);
 }
 
 //PAGEBREAK!
-// Wake up all processes sleeping on chan.
-// The ptable lock must be held.
+// Wake up processes sleeping on chan: all of them if
+// only is zero, otherwise just that one.
+// The woken processes are unlinked from the bucket.
 static void
-wakeup1(void *chan)
+wakeup1(void *chan, struct proc *only)
 {
-  struct proc *p;
+  struct sleepq *sq = sleepq_of(chan);
+  struct proc **pp, *p;
 
-  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++)
-    if(p->state == SLEEPING && p->chan == chan)
+  acquire(&sq->lock);
+  for(pp = &sq->head; (p = *pp) != 0; ){
+    if(p->chan != chan || (only && p != only)){
+      pp = &p->sleepnext;
+      continue;
+    }
+    acquire(&p->lock);
+    *pp = p->sleepnext;
+    p->sleepnext = 0;
+    if(p->state == SLEEPING)
       p->state = RUNNABLE;
+    release(&p->lock);
+  }
+  release(&sq->lock);
 }
 
 // Wake up all processes sleeping on chan.
 void
 wakeup(void *chan)
 {
-  acquire(&ptable.lock);
-  wakeup1(chan);
-  release(&ptable.lock);
+  wakeup1(chan, 0);
 }
 
 // Kill the process with the given pid.
@@ -480,19 +555,24 @@ int
 kill(int pid)
 {
   struct proc *p;
+  void *chan;
 
-  acquire(&ptable.lock);
   for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
+    acquire(&p->lock);
     if(p->pid == pid){
       p->killed = 1;
+      chan = p->state == SLEEPING ? p->chan : 0;
+      release(&p->lock);
       // Wake process from sleep if necessary.
-      if(p->state == SLEEPING)
-        p->state = RUNNABLE;
-      release(&ptable.lock);
+      // The bucket lock comes before p->lock, so this is
+      // done after releasing it; if p woke up meanwhile,
+      // it is no longer in the bucket and is left alone.
+      if(chan)
+        wakeup1(chan, p);
       return 0;
     }
+    release(&p->lock);
   }
-  release(&ptable.lock);
   return -1;
 }
 
@@ -32,10 +32,24 @@ struct context {
   uint eip;
 };
 
+// A memory mapping made by mmap(), of len bytes at start.
+// f is 0 for anonymous memory.
+struct vma {
+  uint start;
+  uint len;                    // 0 if the slot is free
+  int prot;
+  int flags;
+  struct file *f;
+  uint off;                    // File offset of start
+};
+
 enum procstate { UNUSED, EMBRYO, SLEEPING, RUNNABLE, RUNNING, ZOMBIE };
 
 // Per-process state
+// lock protects state, chan, killed and pid.
+// parent is protected by ptable.lock.
 struct proc {
+  struct spinlock lock;
   uint sz;                     // Size of process memory (bytes)
   pde_t* pgdir;                // Page table
   char *kstack;                // Bottom of kernel stack for this process
@@ -45,9 +59,11 @@ struct proc {
   struct trapframe *tf;        // Trap frame for current syscall
   struct context *context;     // swtch() here to run process
   void *chan;                  // If non-zero, sleeping on chan
+  struct proc *sleepnext;      // Next sleeper in the same wait-channel bucket
   int killed;                  // If non-zero, have been killed
   struct file *ofile[NOFILE];  // Open files
   struct inode *cwd;           // Current directory
+  struct vma vma[NVMA];        // Memory mappings
   char name[16];               // Process name (debugging)
 };
 
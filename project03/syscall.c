@@ -3,6 +3,7 @@
 #include "param.h"
 #include "memlayout.h"
 #include "mmu.h"
+#include "spinlock.h"
 #include "proc.h"
 #include "x86.h"
 #include "syscall.h"
@@ -55,20 +56,40 @@ argint(int n, int *ip)
 // Fetch the nth word-sized system call argument as a pointer
 // to a block of memory of size bytes.  Check that the pointer
 // lies within the process address space.
-int
-argptr(int n, char **pp, int size)
+static int
+argmem(int n, char **pp, int size, int write)
 {
   int i;
   struct proc *curproc = myproc();
  
   if(argint(n, &i) < 0)
     return -1;
-  if(size < 0 || (uint)i >= curproc->sz || (uint)i+size > curproc->sz)
+  if(size < 0)
+    return -1;
+  // Outside the image, the buffer must lie in mappings; fault
+  // them in now, since the kernel does not handle its own faults.
+  if(((uint)i >= curproc->sz || (uint)i+size > curproc->sz) &&
+     mmaptouch((uint)i, size, write) < 0)
     return -1;
   *pp = (char*)i;
   return 0;
 }
 
+// A buffer the kernel only reads.
+int
+argptr(int n, char **pp, int size)
+{
+  return argmem(n, pp, size, 0);
+}
+
+// A buffer the kernel writes to: mappings without PROT_WRITE
+// are refused, as the kernel would fault on their pages.
+int
+argwptr(int n, char **pp, int size)
+{
+  return argmem(n, pp, size, 1);
+}
+
 // Fetch the nth word-sized system call argument as a string pointer.
 // Check that the pointer is valid and the string is nul-terminated.
 // (There is no shared writable memory, so the string can't change
@@ -106,6 +127,8 @@ extern int sys_uptime(void);
 extern int sys_symlink(void);
 extern int sys_sync(void);
 extern int sys_read_log(void);
+extern int sys_mmap(void);
+extern int sys_munmap(void);
 
 static int (*syscalls[])(void) = {
 [SYS_fork]    sys_fork,
@@ -132,6 +155,8 @@ static int (*syscalls[])(void) = {
 [SYS_symlink] sys_symlink,
 [SYS_sync]    sys_sync,
 [SYS_read_log] sys_read_log,
+[SYS_mmap]    sys_mmap,
+[SYS_munmap]  sys_munmap,
 };
 
 void
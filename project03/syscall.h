@@ -22,4 +22,6 @@
 #define SYS_close  21
 #define SYS_symlink 22
 #define SYS_sync   23
-#define SYS_read_log 24
\ No newline at end of file
+#define SYS_read_log 24
+#define SYS_mmap   25
+#define SYS_munmap 26
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include "param.h"
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "mman.h"
+
+// TLB benchmark.
+// Maps REGION of anonymous memory with 4KiB pages and then with
+// MAP_HUGE 4MiB pages. For each, prints the time to fault the
+// region in, and to touch one word per 4KiB page ROUNDS times in
+// an order that defeats the TLB: 4096 pages need 4096 TLB entries,
+// 4 huge pages only 4.
+
+#define REGION (16 * 1024 * 1024)
+#define NPAGES (REGION / 4096)
+#define ROUNDS 1000
+
+int stdout = 1;
+
+void
+run(char *name, int flags)
+{
+  volatile int *p;
+  int i, r, start, tfault, twalk;
+
+  p = mmap(0, REGION, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|flags, -1, 0);
+  if(p == MAP_FAILED){
+    printf(stdout, "%s: mmap failed\n", name);
+    return;
+  }
+
+  start = uptime();
+  for(i = 0; i < NPAGES; i++)
+    p[i * 1024] = i;
+  tfault = uptime() - start;
+
+  // 2053 is prime, so i * 2053 % NPAGES visits every page once.
+  start = uptime();
+  for(r = 0; r < ROUNDS; r++)
+    for(i = 0; i < NPAGES; i++)
+      p[(i * 2053 % NPAGES) * 1024] += 1;
+  twalk = uptime() - start;
+
+  for(i = 0; i < NPAGES; i++){
+    if(p[i * 1024] != i + ROUNDS){
+      printf(stdout, "%s: page %d is wrong\n", name, i);
+      break;
+    }
+  }
+  munmap((void*)p, REGION);
+  printf(stdout, "%s: fault-in %d ticks, %d walks %d ticks\n",
+         name, tfault, ROUNDS, twalk);
+}
+
+int
+main(int argc, char *argv[])
+{
+  run("4KiB pages", 0);
+  run("4MiB pages", MAP_HUGE);
+  exit();
+}
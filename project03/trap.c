@@ -3,10 +3,10 @@
 #include "param.h"
 #include "memlayout.h"
 #include "mmu.h"
+#include "spinlock.h"
 #include "proc.h"
 #include "x86.h"
 #include "traps.h"
-#include "spinlock.h"
 
 // Interrupt descriptor table (shared by all CPUs).
 struct gatedesc idt[256];
@@ -77,6 +77,14 @@ trap(struct trapframe *tf)
             cpuid(), tf->cs, tf->eip);
     lapiceoi();
     break;
+  case T_PGFLT:
+    // A page of a memory mapping not touched yet (see mmap.c).
+    if(myproc() && (tf->cs&3) == DPL_USER){
+      sti();
+      if(mmapfault(rcr2(), tf->err) == 0)
+        break;
+    }
+    // fall through
 
   //PAGEBREAK: 13
   default:
@@ -26,6 +26,8 @@ int uptime(void);
 int symlink(const char *, const char *);
 int sync(void);
 int read_log(void);
+void* mmap(void*, int, int, int, int, int);
+int munmap(void*, int);
 
 // ulib.c
 int stat(const char*, struct stat*);
@@ -4,6 +4,7 @@
 #include "x86.h"
 #include "memlayout.h"
 #include "mmu.h"
+#include "spinlock.h"
 #include "proc.h"
 #include "elf.h"
 
@@ -32,7 +33,7 @@ seginit(void)
 // Return the address of the PTE in page table pgdir
 // that corresponds to virtual address va.  If alloc!=0,
 // create any required page table pages.
-static pte_t *
+pte_t *
 walkpgdir(pde_t *pgdir, const void *va, int alloc)
 {
   pde_t *pde;
@@ -40,6 +41,9 @@ walkpgdir(pde_t *pgdir, const void *va, int alloc)
 
   pde = &pgdir[PDX(va)];
   if(*pde & PTE_P){
+    // A 4MiB page has no page table.
+    if(*pde & PTE_PS)
+      return 0;
     pgtab = (pte_t*)P2V(PTE_ADDR(*pde));
   } else {
     if(!alloc || (pgtab = (pte_t*)kalloc()) == 0)
@@ -57,7 +61,7 @@ walkpgdir(pde_t *pgdir, const void *va, int alloc)
 // Create PTEs for virtual addresses starting at va that refer to
 // physical addresses starting at pa. va and size might not
 // be page-aligned.
-static int
+int
 mappages(pde_t *pgdir, void *va, uint size, uint pa, int perm)
 {
   char *a, *last;
@@ -114,6 +118,34 @@ static struct kmap {
  { (void*)DEVSPACE, DEVSPACE,      0,         PTE_W}, // more devices
 };
 
+// Like mappages(), but uses 4MiB pages (PTE_PS) where va and pa
+// are both 4MiB-aligned and one fits in what is left, so that the
+// map of physical memory and devices needs almost no page tables.
+static int
+mapkpages(pde_t *pgdir, void *va, uint size, uint pa, int perm)
+{
+  char *a;
+  uint n;
+
+  a = (char*)va;
+  while(size > 0){
+    if((uint)a % HUGEPGSIZE == 0 && pa % HUGEPGSIZE == 0 && size >= HUGEPGSIZE){
+      if(pgdir[PDX(a)] & PTE_P)
+        panic("remap");
+      pgdir[PDX(a)] = pa | perm | PTE_P | PTE_PS;
+      n = HUGEPGSIZE;
+    } else {
+      if(mappages(pgdir, a, PGSIZE, pa, perm) < 0)
+        return -1;
+      n = PGSIZE;
+    }
+    a += n;
+    pa += n;
+    size = size > n ? size - n : 0;
+  }
+  return 0;
+}
+
 // Set up kernel part of a page table.
 pde_t*
 setupkvm(void)
@@ -127,8 +159,8 @@ setupkvm(void)
   if (P2V(PHYSTOP) > (void*)DEVSPACE)
     panic("PHYSTOP too high");
   for(k = kmap; k < &kmap[NELEM(kmap)]; k++)
-    if(mappages(pgdir, k->virt, k->phys_end - k->phys_start,
-                (uint)k->phys_start, k->perm) < 0) {
+    if(mapkpages(pgdir, k->virt, k->phys_end - k->phys_start,
+                 (uint)k->phys_start, k->perm) < 0) {
       freevm(pgdir);
       return 0;
     }
@@ -291,7 +323,10 @@ freevm(pde_t *pgdir)
   for(i = 0; i < NPDENTRIES; i++){
     if(pgdir[i] & PTE_P){
       char * v = P2V(PTE_ADDR(pgdir[i]));
-      kfree(v);
+      if(!(pgdir[i] & PTE_PS))
+        kfree(v);
+      else if(i < PDX(KERNBASE))
+        kfreehuge(v);  // left by a MAP_HUGE mapping
     }
   }
   kfree((char*)pgdir);